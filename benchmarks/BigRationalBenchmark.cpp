@@ -0,0 +1,74 @@
+#include <chrono>
+#include <iostream>
+#include "../include/MathParser.hpp"
+
+using namespace std;
+
+/**
+ * Сравнение скорости арифметики Fraction и BigRational
+ * На коротких числах BigRational должен работать не медленнее Fraction, длинные числа показаны для сравнения
+ */
+
+const int numberOfEvaluations = 1000000;
+
+// Возвращает среднее время одного вызова func в наносекундах
+template<typename Function>
+double Measure(Function func) {
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < numberOfEvaluations; i++) func(i);
+    auto end = chrono::steady_clock::now();
+
+    return (double) chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / numberOfEvaluations;
+}
+
+// Одна итерация: (x * 3 + 1/7) / (x + 2) - x / 5, x меняется от итерации к итерации
+template<typename Number>
+Number Step(const Number &x, const Number &three, const Number &seventh, const Number &two, const Number &five) {
+    return (x * three + seventh) / (x + two) - x / five;
+}
+
+void BenchmarkSmall() {
+    Fraction fractionThree(3.0), fractionSeventh = Fraction(1.0) / Fraction(7.0), fractionTwo(2.0), fractionFive(5.0);
+    BigRational three(3LL), seventh = BigRational(1LL) / BigRational(7LL), two(2LL), five(5LL);
+    long double fractionChecksum = 0, checksum = 0;
+
+    double fraction = Measure([&](int i) {
+        Fraction x;
+        x.SetNumerator(i % 1000);
+        fractionChecksum += (long double) Step(x, fractionThree, fractionSeventh, fractionTwo, fractionFive);
+    });
+
+    double bigRational = Measure([&](int i) {
+        BigRational x((long long) (i % 1000));
+        checksum += (long double) Step(x, three, seventh, two, five);
+    });
+
+    cout << "small values" << endl;
+    cout << "  Fraction:    " << fraction << " ns" << endl;
+    cout << "  BigRational: " << bigRational << " ns (x" << fraction / bigRational << ")" << endl;
+    cout << "  checksum:    " << fractionChecksum << " " << checksum << endl;
+}
+
+void BenchmarkLarge() {
+    BigRational large("8888809987242424284282");
+    BigRational three(3LL), seventh = BigRational(1LL) / BigRational(7LL), two(2LL), five(5LL);
+    long double checksum = 0;
+
+    double bigRational = Measure([&](int i) {
+        BigRational x = large + BigRational((long long) (i % 1000));
+        checksum += (long double) Step(x, three, seventh, two, five);
+    });
+
+    cout << "large values" << endl;
+    cout << "  BigRational: " << bigRational << " ns" << endl;
+    cout << "  checksum:    " << checksum << endl;
+}
+
+int main() {
+    BenchmarkSmall();
+    BenchmarkLarge();
+
+    CompiledExpression compiled = MathExpression("8888809987242424284282 * x + 1/3").Compile();
+    BigRational value(2LL);
+    cout << "8888809987242424284282 * 2 + 1/3 = " << compiled.EvalExact({&value, 1}).ToString() << endl;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "../include/Fraction.hpp"
+
+using namespace std;
+
+/**
+ * Сравнение перевода long double в дробь на значениях встроенных функций:
+ *  прежний способ (округление до 10^-9 и сокращение) и Fraction(long double),
+ *  который ищет наилучшее приближение по цепной дроби
+ */
+
+const int numberOfValues = 100000;
+
+// Прежний перевод: дробная часть округляется до precision и сокращается двоичным алгоритмом Стейна
+long double FixedPrecision(long double number) {
+    const long long precision = 1000000000;
+    auto integral = (long long) number;
+    auto roundedDecimal = (long long) round((number - (long double) integral) * precision);
+    unsigned long long a = llabs(roundedDecimal), b = precision, gcd = b;
+
+    if (a != 0) {
+        int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        while (b != 0) {
+            b >>= __builtin_ctzll(b);
+            if (a > b) swap(a, b);
+            b -= a;
+        }
+        gcd = a << shift;
+    }
+
+    long long denominator = precision / (long long) gcd;
+    long long numerator = integral * denominator + roundedDecimal / (long long) gcd;
+    return (long double) numerator / denominator;
+}
+
+// Значения встроенных функций на равномерной сетке аргументов
+vector<long double> MakeValues(const function<long double(long double)> &func, long double from, long double to) {
+    vector<long double> values;
+    for (int i = 0; i < numberOfValues; i++) values.push_back(func(from + (to - from) * i / numberOfValues));
+    return values;
+}
+
+// Возвращает среднее время перевода одного значения в наносекундах, в error - наибольшую относительную погрешность
+template<typename Convert>
+double Measure(const vector<long double> &values, Convert convert, long double &error) {
+    long double checksum = 0;
+    error = 0;
+
+    auto begin = chrono::steady_clock::now();
+    for (long double value: values) checksum += convert(value);
+    auto end = chrono::steady_clock::now();
+
+    for (long double value: values)
+        if (value != 0) error = max(error, fabsl(convert(value) - value) / fabsl(value));
+
+    if (checksum == 0.5L) cout << "";
+    return (double) chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / (double) values.size();
+}
+
+void Benchmark(const string &name, const vector<long double> &values) {
+    long double fixedError, bestError, preciseError;
+
+    double fixed = Measure(values, FixedPrecision, fixedError);
+    double best = Measure(values, [](long double value) { return (long double) Fraction(value); }, bestError);
+    double precise = Measure(values, [](long double value) {
+        return (long double) Fraction(value, 1e-15L, Fraction::defaultMaxDenominator);
+    }, preciseError);
+
+    cout << name << endl;
+    cout << "  fixed precision:        " << fixed << " ns, max relative error " << (double) fixedError << endl;
+    cout << "  best rational:          " << best << " ns (x" << fixed / best << "), max relative error "
+         << (double) bestError << endl;
+    cout << "  best rational (1e-15):  " << precise << " ns (x" << fixed / precise << "), max relative error "
+         << (double) preciseError << endl;
+}
+
+int main() {
+    Benchmark("sin(x), x in [-10, 10]", MakeValues([](long double x) { return sinl(x); }, -10, 10));
+    Benchmark("cos(x), x in [-10, 10]", MakeValues([](long double x) { return cosl(x); }, -10, 10));
+    Benchmark("atan(x), x in [-100, 100]", MakeValues([](long double x) { return atanl(x); }, -100, 100));
+    Benchmark("sqrt(x), x in [0, 1000]", MakeValues([](long double x) { return sqrtl(x); }, 0, 1000));
+    Benchmark("sin(x), x in [0, 0.001]", MakeValues([](long double x) { return sinl(x); }, 0, 0.001));
+    Benchmark("int(x), x in [-1000, 1000]", MakeValues([](long double x) { return floorl(x); }, -1000, 1000));
+}
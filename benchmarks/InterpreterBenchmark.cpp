@@ -0,0 +1,221 @@
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include <unordered_map>
+#include "../include/MathParser.hpp"
+
+using namespace std;
+
+/**
+ * Сравнение скорости вычисления одного заранее разобранного выражения:
+ *  обход обратной польской записи со стеком и поиском операций по имени, как вычислял исходный MathExpression::Eval,
+ *  байт-код (CompiledExpression::Eval) и вычисление в double (CompiledExpression::EvalAs<double>)
+ * Для сравнения приводится и разбор строки при каждом вычислении (MathExpression::Eval)
+ */
+
+const int numberOfEvaluations = 200000;
+
+// Возвращает среднее время одного вызова func в наносекундах
+template<typename Function>
+double Measure(Function func) {
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < numberOfEvaluations; i++) func(i);
+    auto end = chrono::steady_clock::now();
+
+    return (double) chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / numberOfEvaluations;
+}
+
+// Эталонный интерпретатор токенов: операции те же, что в Operations, и вызываются через function по имени
+class TokenInterpreter {
+private:
+    enum TypeOfTokens { number, variable, unaryOperation, binaryOperation, func, leftBracket };
+
+    struct Token {
+        TypeOfTokens type;
+        string name;
+        Fraction value = Fraction();
+        size_t index = 0;
+    };
+
+    unordered_map<string, function<Fraction(const Fraction &)>> unaryOperations = {
+            {"-", [](const Fraction &a) { return -a; }}
+    };
+
+    unordered_map<string, function<Fraction(const Fraction &, const Fraction &)>> binaryOperations = {
+            {"+", [](const Fraction &a, const Fraction &b) { return a + b; }},
+            {"-", [](const Fraction &a, const Fraction &b) { return a - b; }},
+            {"*", [](const Fraction &a, const Fraction &b) { return a * b; }},
+            {"/", [](const Fraction &a, const Fraction &b) { return a / b; }},
+            {"^", [](const Fraction &a, const Fraction &b) { return Fraction::Power(a, b); }}
+    };
+
+    unordered_map<string, function<Fraction(const vector<Fraction> &)>> functions = {
+            {"sin",  [](const vector<Fraction> &a) { return Fraction(sin((long double) a[0])); }},
+            {"cos",  [](const vector<Fraction> &a) { return Fraction(cos((long double) a[0])); }},
+            {"abs",  [](const vector<Fraction> &a) { return Fraction(abs((long double) a[0])); }},
+            {"int",  [](const vector<Fraction> &a) { return Fraction(floor((long double) a[0])); }},
+            {"sqrt", [](const vector<Fraction> &a) { return Fraction::Power(a[0], Fraction(0.5)); }}
+    };
+
+    vector<Token> postfix;
+
+    static int GetPriority(const Token &token) {
+        if (token.type == unaryOperation) return 3;
+        if (token.type == func) return 5;
+        if (token.name == "^") return 4;
+        return (token.name == "+" || token.name == "-" ? 1 : 2);
+    }
+
+public:
+
+    // Переводит выражение с переменными x, y в обратную польскую запись алгоритмом сортировочной станции
+    explicit TokenInterpreter(const string &expression) {
+        vector<Token> tokens;
+        bool isOperandExpected = true;
+
+        for (size_t i = 0; i < expression.size();) {
+            char symbol = expression[i];
+            Token token;
+
+            if (symbol == ' ') {
+                i++;
+                continue;
+            }
+
+            if (isdigit(symbol)) {
+                size_t length = 0;
+                while (i + length < expression.size() &&
+                       (isdigit(expression[i + length]) || expression[i + length] == '.'))
+                    length++;
+                postfix.push_back({number, "", Fraction(expression.substr(i, length))});
+                i += length;
+                isOperandExpected = false;
+            } else if (isalpha(symbol)) {
+                size_t length = 0;
+                while (i + length < expression.size() && isalpha(expression[i + length])) length++;
+                string name = expression.substr(i, length);
+                i += length;
+
+                if (functions.count(name)) tokens.push_back({func, name});
+                else {
+                    postfix.push_back({variable, name, Fraction(), (size_t) (name == "y")});
+                    isOperandExpected = false;
+                }
+            } else if (symbol == '(') {
+                tokens.push_back({leftBracket});
+                i++;
+                isOperandExpected = true;
+            } else if (symbol == ')') {
+                while (tokens.back().type != leftBracket) {
+                    postfix.push_back(tokens.back());
+                    tokens.pop_back();
+                }
+                tokens.pop_back();
+                if (!tokens.empty() && tokens.back().type == func) {
+                    postfix.push_back(tokens.back());
+                    tokens.pop_back();
+                }
+                i++;
+                isOperandExpected = false;
+            } else {
+                token = {(isOperandExpected ? unaryOperation : binaryOperation), string(1, symbol)};
+                // Унарные операции и степень правоассоциативны
+                bool isRightAssociative = (token.type == unaryOperation || token.name == "^");
+
+                while (token.type == binaryOperation && !tokens.empty() && tokens.back().type != leftBracket &&
+                       (GetPriority(tokens.back()) > GetPriority(token) ||
+                        (GetPriority(tokens.back()) == GetPriority(token) && !isRightAssociative))) {
+                    postfix.push_back(tokens.back());
+                    tokens.pop_back();
+                }
+                tokens.push_back(token);
+                i++;
+                isOperandExpected = true;
+            }
+        }
+
+        while (!tokens.empty()) {
+            postfix.push_back(tokens.back());
+            tokens.pop_back();
+        }
+    }
+
+    Fraction Eval(const Fraction *values) {
+        vector<Fraction> numbers, args;
+
+        for (const auto &iter: postfix) {
+            switch (iter.type) {
+                case number:
+                    numbers.push_back(iter.value);
+                    break;
+                case variable:
+                    numbers.push_back(values[iter.index]);
+                    break;
+                case unaryOperation:
+                    numbers.back() = unaryOperations[iter.name](numbers.back());
+                    break;
+                case binaryOperation: {
+                    Fraction b = numbers.back();
+                    numbers.pop_back();
+                    numbers.back() = binaryOperations[iter.name](numbers.back(), b);
+                    break;
+                }
+                case func:
+                    args.assign(1, numbers.back());
+                    numbers.back() = functions[iter.name](args);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return numbers.back();
+    }
+};
+
+void Benchmark(const string &input) {
+    CompiledExpression compiled = MathExpression(input).Compile(vector<string>{"x", "y"});
+    TokenInterpreter interpreter(input);
+    long double checksum = 0;
+
+    double tokens = Measure([&](int i) {
+        Fraction values[] = {Fraction((long double) (i % 100)), Fraction((long double) (i % 7 + 1))};
+        checksum += (long double) interpreter.Eval(values);
+    });
+
+    double bytecode = Measure([&](int i) {
+        Fraction values[] = {Fraction((long double) (i % 100)), Fraction((long double) (i % 7 + 1))};
+        checksum += (long double) compiled.Eval(values);
+    });
+
+    double native = Measure([&](int i) {
+        double values[] = {(double) (i % 100), (double) (i % 7 + 1)};
+        checksum += compiled.EvalAs<double>(values);
+    });
+
+    double parsing = Measure([&](int i) {
+        string expression = input;
+        // Подставляем значения переменных в строку, как это приходилось делать без поддержки переменных
+        for (size_t position; (position = expression.find('x')) != string::npos;)
+            expression.replace(position, 1, "(" + to_string(i % 100) + ")");
+        for (size_t position; (position = expression.find('y')) != string::npos;)
+            expression.replace(position, 1, "(" + to_string(i % 7 + 1) + ")");
+        checksum += (long double) MathExpression(expression).Eval();
+    });
+
+    cout << input << endl;
+    cout << "  tokens:       " << tokens << " ns" << endl;
+    cout << "  bytecode:     " << bytecode << " ns (x" << tokens / bytecode << ")" << endl;
+    cout << "  double:       " << native << " ns (x" << tokens / native << ")" << endl;
+    cout << "  parse + eval: " << parsing << " ns" << endl;
+    cout << "  checksum:     " << checksum << endl;
+}
+
+int main() {
+    Benchmark("x * 2 + y / 4 - 3");
+    Benchmark("-x^2 + 3 * x * y - y / 7 + 1");
+    Benchmark("abs(x - y) * (x + y) + int(x / y) * 2");
+    Benchmark("sin(x)^2 + cos(y) * sqrt(x + y)");
+}
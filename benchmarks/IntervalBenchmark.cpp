@@ -0,0 +1,70 @@
+#include <chrono>
+#include <iostream>
+#include "../include/MathParser.hpp"
+
+using namespace std;
+
+/**
+ * Сравнение оценки значений выражения на области:
+ *  перебор точек сетки через Eval, одно интервальное вычисление (EvalAs<Interval>)
+ *  и поиск глобального минимума и максимума методом ветвей и границ (FindMinimum, FindMaximum)
+ * Перебор дает лишь найденные в точках значения, интервальные способы - гарантированные границы
+ */
+
+const int gridSize = 300;
+
+// Возвращает время вызова func в миллисекундах
+template<typename Function>
+double Measure(Function func) {
+    auto begin = chrono::steady_clock::now();
+    func();
+    auto end = chrono::steady_clock::now();
+
+    return (double) chrono::duration_cast<chrono::microseconds>(end - begin).count() / 1000;
+}
+
+void Benchmark(const string &input, const vector<Interval> &box) {
+    CompiledExpression compiled = MathExpression(input).Compile();
+    long double sampledMinimum = numeric_limits<long double>::infinity(), sampledMaximum = -sampledMinimum;
+    Interval bound;
+    CompiledExpression::Extremum minimum, maximum;
+
+    double sampling = Measure([&]() {
+        vector<Fraction> values(box.size());
+        vector<size_t> indexes(box.size(), 0);
+
+        // Перебор всех точек сетки gridSize^n
+        while (indexes.back() <= gridSize) {
+            for (size_t i = 0; i < box.size(); i++)
+                values[i] = Fraction(box[i].GetLower() + box[i].GetWidth() * (long double) indexes[i] / gridSize);
+
+            auto value = (long double) compiled.Eval(values);
+            sampledMinimum = min(sampledMinimum, value);
+            sampledMaximum = max(sampledMaximum, value);
+
+            for (size_t i = 0; i < box.size() && ++indexes[i] > gridSize && i + 1 < box.size(); i++) indexes[i] = 0;
+        }
+    });
+
+    double interval = Measure([&]() { bound = compiled.EvalAs<Interval>(box); });
+
+    double branchAndBound = Measure([&]() {
+        minimum = compiled.FindMinimum(box);
+        maximum = compiled.FindMaximum(box);
+    });
+
+    cout << input << endl;
+    cout << "  grid " << gridSize + 1 << "^" << box.size() << " via Eval: " << sampling << " ms, sampled ["
+         << sampledMinimum << ", " << sampledMaximum << "]" << endl;
+    cout << "  one interval pass:   " << interval << " ms, bound [" << bound.GetLower() << ", " << bound.GetUpper()
+         << "]" << endl;
+    cout << "  branch and bound:    " << branchAndBound << " ms, min in [" << minimum.value.GetLower() << ", "
+         << minimum.value.GetUpper() << "], max in [" << maximum.value.GetLower() << ", "
+         << maximum.value.GetUpper() << "], boxes " << minimum.numberOfBoxes + maximum.numberOfBoxes << endl;
+}
+
+int main() {
+    Benchmark("(x - 1)^2 + sin(3 * x) * y", {{-2, 3}, {0.5L, 1}});
+    Benchmark("x * cos(x) - y^2 / 4 + abs(x - y)", {{-3, 3}, {-3, 3}});
+    Benchmark("sqrt(x^2 + y^2) - atan(x * y) + int(x)", {{-1, 2}, {-2, 2}});
+}
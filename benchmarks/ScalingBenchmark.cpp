@@ -0,0 +1,77 @@
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <iostream>
+#include "../include/MathParser.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+/**
+ * Масштабирование параллельного CompiledExpression::EvalBatch по числу потоков
+ * Для каждого числа потоков от 1 до максимального (удваивая) выводится время, ускорение относительно
+ * одного потока и эффективность (ускорение, деленное на число потоков)
+ * Необязательные аргументы: максимальное число потоков и число строк
+ */
+
+const int numberOfRepetitions = 5;
+
+// Возвращает лучшее время вычисления всех строк в миллисекундах
+double Measure(const CompiledExpression &compiled, const vector<const double *> &columns, vector<double> &result,
+               ThreadPool &pool) {
+    double best = 0;
+
+    for (int i = 0; i < numberOfRepetitions; i++) {
+        auto begin = chrono::steady_clock::now();
+        compiled.EvalBatch(columns, result, pool);
+        auto end = chrono::steady_clock::now();
+
+        double time = chrono::duration<double, milli>(end - begin).count();
+        if (i == 0 || time < best) best = time;
+    }
+
+    return best;
+}
+
+void Benchmark(const string &input, size_t numberOfRows, size_t maxNumberOfThreads) {
+    CompiledExpression compiled = MathExpression(input).Compile(vector<string>{"x", "y"});
+    vector<double> x(numberOfRows), y(numberOfRows), result(numberOfRows);
+    vector<const double *> columns = {x.data(), y.data()};
+    double single = 0;
+
+    for (size_t i = 0; i < numberOfRows; i++) {
+        x[i] = (double) (i % 1000) / 10;
+        y[i] = (double) (i % 7 + 1);
+    }
+
+    cout << input << " (" << numberOfRows << " строк)" << endl;
+
+    for (size_t numberOfThreads = 1;; numberOfThreads = min(numberOfThreads * 2, maxNumberOfThreads)) {
+        ThreadPool pool(numberOfThreads);
+        double time = Measure(compiled, columns, result, pool);
+        if (numberOfThreads == 1) single = time;
+
+        double checksum = 0;
+        for (double iter: result) checksum += iter;
+
+        cout << "  потоков: " << numberOfThreads << ", время: " << time << " мс, ускорение: x" << single / time
+             << ", эффективность: " << single / time / (double) numberOfThreads * 100 << "%, сумма: " << checksum
+             << endl;
+
+        if (numberOfThreads == maxNumberOfThreads) break;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t maxNumberOfThreads = max(thread::hardware_concurrency(), 1u);
+    size_t numberOfRows = 4 << 20;
+
+    if (argc > 1) maxNumberOfThreads = max(strtoul(argv[1], nullptr, 10), 1ul);
+    if (argc > 2) numberOfRows = strtoul(argv[2], nullptr, 10);
+
+    // Только пакетные ядра: стоимость строки мала, важно не тратить время на планирование
+    Benchmark("-x^2 + 3 * x * y - y / 7 + 1", numberOfRows, maxNumberOfThreads);
+    // Функция без ядра вычисляется через Fraction: стоимость строки на порядки выше
+    Operations::GetInstance().AddFunction("min", [](const vector<Fraction> &a) { return min(a[0], a[1]); }, 4, 2);
+    Benchmark("min(x, y) * 2 + min(x * y, 3) / y", numberOfRows / 16, maxNumberOfThreads);
+}
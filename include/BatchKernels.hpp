@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Класс ядер пакетного вычисления
+ * Каждое ядро применяет одну операцию сразу к блоку строк, хранящихся в массивах double
+ * Арифметика, abs, int и sqrt векторизованы с помощью AVX2 или SSE2, остальные функции вызываются поэлементно
+ */
+class BatchKernels {
+public:
+
+    /**
+     * Поле класса BatchKernels
+     * blockSize - количество строк, которое обрабатывается за один проход программы
+     */
+    static const size_t blockSize = 256;
+
+    /**
+     * Поле класса BatchKernels
+     * TypeOfKernels - перечисление ядер
+     * generic - операция не имеет ядра и вычисляется поэлементно через Fraction
+     */
+    enum TypeOfKernels {
+        generic, plus, negate, add, subtract, multiply, divide, power, exponent,
+        sine, cosine, tangent, cotangent, arcsine, arccosine, arctangent, arccotangent,
+        absolute, integral, squareRoot
+    };
+
+    /**
+     * Поле класса BatchKernels
+     * functionKernels - хранит имена встроенных функций одного аргумента и их ядра
+     * Таблица доступна при компиляции программы, по ней же разбирает функции StaticExpression
+     */
+    static constexpr pair<string_view, TypeOfKernels> functionKernels[] = {
+            {"sin",    sine},
+            {"cos",    cosine},
+            {"tg",     tangent},
+            {"tan",    tangent},
+            {"ctg",    cotangent},
+            {"arcsin", arcsine},
+            {"arccos", arccosine},
+            {"arctg",  arctangent},
+            {"arctan", arctangent},
+            {"arcctg", arccotangent},
+            {"asin",   arcsine},
+            {"acos",   arccosine},
+            {"atg",    arctangent},
+            {"atan",   arctangent},
+            {"actg",   arccotangent},
+            {"abs",    absolute},
+            {"int",    integral},
+            {"sqrt",   squareRoot}
+    };
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * FindUnaryKernel - возвращает ядро унарной операции по ее имени
+     */
+    static TypeOfKernels FindUnaryKernel(const string &name);
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * FindBinaryKernel - возвращает ядро бинарной операции по ее имени
+     */
+    static TypeOfKernels FindBinaryKernel(const string &name);
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * FindFunctionKernel - возвращает ядро функции одного аргумента по ее имени
+     */
+    static TypeOfKernels FindFunctionKernel(const string &name);
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * Power - возводит a в степень b
+     * Отрицательное основание в нецелой степени вычисляется по правилам Fraction::Power,
+     * чтобы (-8)^(1/3) давало -2, а не nan
+     */
+    static double Power(double a, double b);
+
+    static long double Power(long double a, long double b);
+
+    /**
+     * Статические функции-члены класса BatchKernels
+     * Apply - применяет ядро унарной операции или функции одного аргумента (Apply(kernel, a))
+     * либо бинарной операции (Apply(kernel, a, b)) к одному значению
+     * Определены в BatchKernels.cpp для double и long double, вычисления идут без перевода в Fraction
+     */
+    template<typename Number>
+    static Number Apply(TypeOfKernels kernel, Number a);
+
+    template<typename Number>
+    static Number Apply(TypeOfKernels kernel, Number a, Number b);
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * Fill - заполняет блок значением value
+     */
+    static void Fill(double *a, double value, size_t size);
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * Unary - применяет унарную операцию или функцию одного аргумента к блоку a на месте
+     */
+    static void Unary(TypeOfKernels kernel, double *a, size_t size);
+
+    /**
+     * Статическая функция-член класса BatchKernels
+     * Binary - вычисляет a[i] = a[i] op b[i] для всего блока
+     */
+    static void Binary(TypeOfKernels kernel, double *a, const double *b, size_t size);
+};
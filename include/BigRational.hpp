@@ -0,0 +1,285 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Fraction.hpp"
+
+using namespace std;
+
+/**
+ * Класс рациональных чисел произвольной точности
+ * Пока числитель и знаменатель помещаются в long long, число хранится прямо в объекте и арифметика идет
+ * так же, как у Fraction: в long long с проверкой переполнения, затем в __int128
+ * Если результат не помещается и после сокращения, число переходит в длинное представление: числитель
+ * и знаменатель хранятся 32-битными разрядами в куче, а сами длинные значения берутся из пула потока
+ * Длинное число всегда несократимо и при возможности возвращается в короткое представление
+ */
+class BigRational {
+private:
+
+    /**
+     * Поле класса BigRational
+     * Big - структура длинного представления, определена в BigRational.cpp
+     */
+    struct Big;
+
+    /**
+     * Поля класса BigRational
+     * numerator, denominator - числитель и знаменатель короткого представления, знаменатель положителен
+     */
+    long long numerator = 0;
+    long long denominator = 1;
+
+    /**
+     * Поле класса BigRational
+     * big - длинное представление, nullptr - если число короткое
+     */
+    Big *big = nullptr;
+
+    /**
+     * Закрытый конструктор класса BigRational
+     * Создает короткое число numerator / denominator, denominator положителен
+     */
+    BigRational(long long numerator, long long denominator) : numerator(numerator), denominator(denominator) {}
+
+    /**
+     * Закрытая статическая функция-член класса BigRational
+     * Make - возвращает число numerator / denominator, denominator не равен нулю
+     * Сокращает дробь, только если она не помещается в long long, и переходит в длинное представление,
+     * если не помещается и после сокращения
+     */
+    static BigRational Make(__int128 numerator, __int128 denominator);
+
+    /**
+     * Закрытая статическая функция-член класса BigRational
+     * Add - складывает a и b, если isSubtraction - вычитает b из a
+     * Вызывается, когда результат не удалось получить в long long
+     */
+    static BigRational Add(const BigRational &a, const BigRational &b, bool isSubtraction);
+
+    /**
+     * Закрытая статическая функция-член класса BigRational
+     * Multiply - умножает a на b, если isDivision - делит a на b
+     * Вызывается, когда результат не удалось получить в long long
+     */
+    static BigRational Multiply(const BigRational &a, const BigRational &b, bool isDivision);
+
+    /**
+     * Закрытая статическая функция-член класса BigRational
+     * Compare - возвращает отрицательное число, ноль или положительное число, если a меньше, равно или больше b
+     */
+    static int Compare(const BigRational &a, const BigRational &b);
+
+    /**
+     * Закрытые статические функции-члены класса BigRational
+     * Allocate, Release - берут длинное значение из пула потока и возвращают его туда
+     * Разряды значений из пула сохраняют выделенную память, поэтому длинная арифметика редко обращается к куче
+     */
+    static Big *Allocate();
+
+    static void Release(Big *value);
+
+    /**
+     * Закрытая функция-член класса BigRational
+     * CopyBig - копирует длинное представление other, при необходимости берет значение из пула
+     */
+    void CopyBig(const BigRational &other);
+
+    /**
+     * Закрытая статическая функция-член класса BigRational
+     * FromParts - возвращает несократимое число со знаком isNegative и разрядами numerator и denominator
+     * Разряды могут быть перемещены в результат, после вызова их значение не определено
+     */
+    static BigRational FromParts(bool isNegative, vector<uint32_t> &numerator, vector<uint32_t> &denominator);
+
+    /**
+     * Закрытая функция-член класса BigRational
+     * GetParts - возвращает знак и разряды числа, для короткого числа разряды записываются в хранилища storage
+     */
+    void GetParts(bool &isNegative, const vector<uint32_t> *&numerator, const vector<uint32_t> *&denominator,
+                  vector<uint32_t> &numeratorStorage, vector<uint32_t> &denominatorStorage) const;
+
+public:
+
+    /**
+     * Конструктор по умолчанию класса BigRational
+     * Создает число 0
+     */
+    BigRational() = default;
+
+    /**
+     * Конструктор с целым аргументом класса BigRational
+     */
+    explicit BigRational(long long number) : numerator(number) {}
+
+    /**
+     * Конструктор с аргументом Fraction класса BigRational
+     * Число равно дроби точно
+     */
+    explicit BigRational(const Fraction &fraction);
+
+    /**
+     * Конструктор с числовым аргументом класса BigRational
+     * Число равно двоичному значению number точно
+     */
+    explicit BigRational(const long double &number);
+
+    /**
+     * Конструктор со строковым аргументом класса BigRational
+     * Разбирает десятичную запись (цифры, необязательная точка и показатель степени) любой длины без округления
+     */
+    explicit BigRational(const string &str);
+
+    /**
+     * Копирующий и перемещающий конструкторы, присваивания и деструктор класса BigRational
+     * Определены в заголовке, чтобы временные короткие числа не вызывали функций: длинное значение
+     * копируется в CopyBig, а освобождается возвращением в пул потока
+     */
+    BigRational(const BigRational &other) : numerator(other.numerator), denominator(other.denominator) {
+        if (other.big) CopyBig(other);
+    }
+
+    BigRational(BigRational &&other) noexcept
+            : numerator(other.numerator), denominator(other.denominator), big(other.big) {
+        other.big = nullptr;
+    }
+
+    BigRational &operator=(const BigRational &other) {
+        if (this == &other) return *this;
+
+        numerator = other.numerator;
+        denominator = other.denominator;
+        if (other.big) CopyBig(other);
+        else if (big) {
+            Release(big);
+            big = nullptr;
+        }
+
+        return *this;
+    }
+
+    BigRational &operator=(BigRational &&other) noexcept {
+        if (this == &other) return *this;
+
+        if (big) Release(big);
+        numerator = other.numerator;
+        denominator = other.denominator;
+        big = other.big;
+        other.big = nullptr;
+
+        return *this;
+    }
+
+    ~BigRational() {
+        if (big) Release(big);
+    }
+
+    /**
+     * Функция-член класса BigRational
+     * IsSmall - возвращает true, если число хранится в коротком представлении
+     */
+    bool IsSmall() const;
+
+    /**
+     * Функции-члены класса BigRational
+     * GetNumerator, GetDenominator - возвращают числитель и знаменатель короткого представления
+     * Для длинного числа выбрасывают исключение
+     */
+    long long GetNumerator() const;
+
+    long long GetDenominator() const;
+
+    /**
+     * Функция-член класса BigRational
+     * IsInteger - возвращает true, если число целое
+     */
+    bool IsInteger() const;
+
+    /**
+     * Функция-член класса BigRational
+     * ToString - возвращает точную запись числа: целое или "числитель/знаменатель" в несократимом виде
+     */
+    string ToString() const;
+
+    /**
+     * Функция-член класса BigRational
+     * ToFraction - возвращает число в виде Fraction: короткое число - точно, длинное - с точностью Fraction
+     * Если число не помещается в Fraction, выбрасывает исключение
+     */
+    Fraction ToFraction() const;
+
+    /**
+     * Перегрузка операторов
+     * Сложение, вычитание и умножение коротких чисел без переполнения выполняются прямо в заголовке,
+     * остальные случаи переходят в Add и Multiply
+     */
+
+    explicit operator long double() const;
+
+    explicit operator double() const;
+
+    BigRational operator+(const BigRational &other) const {
+        long long a, b, sum, product;
+
+        if (!big && !other.big) {
+            if (denominator == other.denominator && !__builtin_add_overflow(numerator, other.numerator, &sum))
+                return {sum, denominator};
+            if (!__builtin_mul_overflow(numerator, other.denominator, &a) &&
+                !__builtin_mul_overflow(denominator, other.numerator, &b) && !__builtin_add_overflow(a, b, &sum) &&
+                !__builtin_mul_overflow(denominator, other.denominator, &product))
+                return {sum, product};
+        }
+
+        return Add(*this, other, false);
+    }
+
+    BigRational operator-(const BigRational &other) const {
+        long long a, b, difference, product;
+
+        if (!big && !other.big) {
+            if (denominator == other.denominator && !__builtin_sub_overflow(numerator, other.numerator, &difference))
+                return {difference, denominator};
+            if (!__builtin_mul_overflow(numerator, other.denominator, &a) &&
+                !__builtin_mul_overflow(denominator, other.numerator, &b) && !__builtin_sub_overflow(a, b, &difference) &&
+                !__builtin_mul_overflow(denominator, other.denominator, &product))
+                return {difference, product};
+        }
+
+        return Add(*this, other, true);
+    }
+
+    BigRational operator-() const;
+
+    BigRational operator*(const BigRational &other) const {
+        long long a, b;
+
+        if (!big && !other.big && !__builtin_mul_overflow(numerator, other.numerator, &a) &&
+            !__builtin_mul_overflow(denominator, other.denominator, &b))
+            return {a, b};
+
+        return Multiply(*this, other, false);
+    }
+
+    BigRational operator/(const BigRational &other) const;
+
+    bool operator<(const BigRational &other) const;
+
+    bool operator<=(const BigRational &other) const;
+
+    bool operator>(const BigRational &other) const;
+
+    bool operator>=(const BigRational &other) const;
+
+    bool operator==(const BigRational &other) const;
+
+    bool operator!=(const BigRational &other) const;
+
+    /**
+     * Статическая функция-член класса BigRational
+     * Power - возводит a в степень b
+     * Целая степень вычисляется точно возведением в квадрат, дробная - так же, как Fraction::Power
+     */
+    static BigRational Power(const BigRational &a, const BigRational &b);
+};
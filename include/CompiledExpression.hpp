@@ -0,0 +1,394 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <span>
+#include <cstdint>
+#include <functional>
+
+#include "Fraction.hpp"
+#include "BigRational.hpp"
+#include "Interval.hpp"
+#include "BatchKernels.hpp"
+#include "EvaluationArena.hpp"
+
+using namespace std;
+
+class ThreadPool;
+
+/**
+ * Класс скомпилированных математических выражений
+ * Хранит выражение в виде ациклического графа: одинаковые подвыражения хранятся и вычисляются один раз
+ * Инструкции графа упорядочены так, что операнды вычисляются раньше операций, результат каждой записывается в регистр
+ * Для Eval граф дополнительно переводится в байт-код с составными командами, который исполняет регистровая машина
+ * После создания объект не изменяется, поэтому Eval можно вызывать одновременно из нескольких потоков
+ */
+class CompiledExpression {
+private:
+
+    /**
+     * Дружественный класс MathExpression
+     * Только MathExpression создает и заполняет скомпилированные выражения
+     */
+    friend class MathExpression;
+
+    /**
+     * Дружественный класс JitExpression
+     * JitExpression переводит инструкции графа в машинный код
+     */
+    friend class JitExpression;
+
+    /**
+     * Дружественный класс NativeModule
+     * NativeModule переводит инструкции графа в исходный код C++
+     */
+    friend class NativeModule;
+
+    /**
+     * Поле класса CompiledExpression
+     * TypeOfInstructions - перечисление типов инструкций
+     */
+    enum TypeOfInstructions {
+        constant, variable, unaryOperation, binaryOperation, func
+    };
+
+    /**
+     * Поле класса CompiledExpression
+     * Instruction - структура инструкции
+     */
+    struct Instruction {
+
+        /**
+         * Поле структуры Instruction
+         * type - хранит тип инструкции
+         */
+        TypeOfInstructions type;
+        /**
+         * Поле структуры Instruction
+         * index - хранит индекс в пуле констант, ячейку переменной или индекс в пуле операций соответствующего типа
+         */
+        size_t index;
+        /**
+         * Поле структуры Instruction
+         * numberOfArguments - хранит количество аргументов функции
+         */
+        size_t numberOfArguments;
+        /**
+         * Поле структуры Instruction
+         * kernel - хранит ядро операции для пакетного вычисления
+         */
+        BatchKernels::TypeOfKernels kernel;
+        /**
+         * Поле структуры Instruction
+         * isPure - хранит true, если результат зависит только от операндов
+         * Только такие инструкции сворачиваются в константы и объединяются с одинаковыми подвыражениями
+         */
+        bool isPure;
+        /**
+         * Поле структуры Instruction
+         * firstOperand - хранит индекс первого регистра операндов в operands (после построения графа)
+         */
+        size_t firstOperand;
+        /**
+         * Поле структуры Instruction
+         * result - хранит регистр, в который записывается результат (после построения графа)
+         */
+        size_t result;
+    };
+
+    /**
+     * Поле класса CompiledExpression
+     * instructions - хранит программу: при компиляции в виде обратной польской нотации, затем в виде графа
+     */
+    vector<Instruction> instructions;
+
+    /**
+     * Поле класса CompiledExpression
+     * operands - хранит регистры операндов инструкций подряд
+     */
+    vector<size_t> operands;
+
+    /**
+     * Поле класса CompiledExpression
+     * TypeOfCommands - перечисление команд байт-кода
+     * Команды с Constant в имени берут один операнд из пула констант вместо регистра:
+     *  addConstant - r = a + K, constantSubtract - r = K - a
+     * multiplyAdd - r = a * b + c, negatePower - r = -(a ^ b), negatePowerConstant - r = -(a ^ K)
+     * callUnary, callBinary, callFunction - вызов операций, у которых нет своей команды
+     * stop - завершает вычисление, ответ находится в регистре result
+     */
+    enum TypeOfCommands : uint8_t {
+        loadConstant, loadVariable, add, subtract, multiply, divide, power, exponent, negate,
+        addConstant, subtractConstant, multiplyConstant, divideConstant, powerConstant,
+        constantSubtract, constantDivide, constantPower, multiplyAdd, negatePower, negatePowerConstant,
+        callUnary, callBinary, callFunction, stop
+    };
+
+    /**
+     * Поле класса CompiledExpression
+     * Command - структура команды байт-кода
+     * result - регистр результата, a, b, c - регистры операндов, индекс константы или индекс в пуле операций
+     * Для callFunction a - индекс первого регистра аргументов в commandOperands, b - количество аргументов
+     */
+    struct Command {
+        TypeOfCommands code;
+        uint32_t result;
+        uint32_t a;
+        uint32_t b;
+        uint32_t c;
+    };
+
+    /**
+     * Поле класса CompiledExpression
+     * commands - хранит байт-код, исполняемый Eval
+     */
+    vector<Command> commands;
+
+    /**
+     * Поле класса CompiledExpression
+     * commandOperands - хранит регистры аргументов команд callFunction
+     */
+    vector<uint32_t> commandOperands;
+
+    /**
+     * Поле класса CompiledExpression
+     * numberOfCommandRegisters - хранит количество регистров, нужных байт-коду
+     */
+    size_t numberOfCommandRegisters = 0;
+
+    /**
+     * Поле класса CompiledExpression
+     * maxNumberOfArguments - хранит наибольшее количество аргументов команд callFunction
+     * Вместе с numberOfCommandRegisters задает размер рабочей памяти, который известен после компиляции
+     */
+    size_t maxNumberOfArguments = 0;
+
+    /**
+     * Поле класса CompiledExpression
+     * constants - хранит пул заранее разобранных чисел
+     */
+    vector<Fraction> constants;
+
+    /**
+     * Поле класса CompiledExpression
+     * exactConstants - хранит те же числа без округления, exactConstants[i] соответствует constants[i]
+     */
+    vector<BigRational> exactConstants;
+
+    /**
+     * Поле класса CompiledExpression
+     * hasLargeConstants - хранит true, если какое-то число не помещается в Fraction
+     * Такое выражение вычисляется только EvalExact, а Eval выбрасывает исключение
+     */
+    bool hasLargeConstants = false;
+
+    /**
+     * Поля класса CompiledExpression
+     * doubleConstants, longDoubleConstants - хранят пул констант, заранее переведенный в double и long double
+     */
+    vector<double> doubleConstants;
+    vector<long double> longDoubleConstants;
+
+    /**
+     * Поле класса CompiledExpression
+     * intervalConstants - хранит интервалы, которые гарантированно содержат точные значения констант
+     * Число из записи дает интервал по exactConstants, свернутая константа - интервальным вычислением операции,
+     * поэтому округление Fraction при свертке (нап. sin(1)) не нарушает интервальную оценку
+     */
+    vector<Interval> intervalConstants;
+
+    /**
+     * Поле класса CompiledExpression
+     * variables - хранит имена переменных, индекс имени равен номеру ячейки переменной
+     */
+    vector<string> variables;
+
+    /**
+     * Поля класса CompiledExpression
+     * unaryOperations, binaryOperations, functions - хранят пулы операций, используемых в выражении
+     * Операции копируются из Operations, поэтому последующие изменения Operations не влияют на выражение
+     */
+    vector<function<Fraction(const Fraction &)>> unaryOperations;
+    vector<function<Fraction(const Fraction &, const Fraction &)>> binaryOperations;
+    vector<function<Fraction(const vector<Fraction> &)>> functions;
+
+    /**
+     * Поле класса CompiledExpression
+     * numberOfRegisters - хранит количество регистров, нужных для вычисления
+     */
+    size_t numberOfRegisters = 0;
+
+    /**
+     * Поле класса CompiledExpression
+     * numberOfDeduplicatedNodes - хранит количество вершин, совпавших с уже построенными при построении графа
+     */
+    size_t numberOfDeduplicatedNodes = 0;
+
+    /**
+     * Закрытый конструктор по умолчанию класса CompiledExpression
+     */
+    CompiledExpression() = default;
+
+    /**
+     * Закрытая функция-член класса CompiledExpression
+     * FoldInstruction - если все операнды инструкции являются константами, вычисляет ее при компиляции
+     * и заменяет операнды одной константой. Возвращает true, если свертка выполнена
+     * Если вычисление выбрасывает исключение, свертка не выполняется и ошибка возникнет при Eval
+     */
+    bool FoldInstruction(const Instruction &instruction);
+
+    /**
+     * Закрытая функция-член класса CompiledExpression
+     * ApplyExact - вычисляет операцию инструкции над точными значениями args
+     * Арифметика и степень вычисляются в BigRational, остальные операции - своими функциями через Fraction
+     */
+    BigRational ApplyExact(const Instruction &instruction, const vector<BigRational> &args) const;
+
+    /**
+     * Закрытая функция-член класса CompiledExpression
+     * ApplyInterval - вычисляет операцию инструкции над интервалами args
+     * Встроенные операции вычисляются в Interval, операции пользователя - через Fraction и только для точек,
+     * для остальных интервалов выбрасывается исключение
+     */
+    Interval ApplyInterval(const Instruction &instruction, const vector<Interval> &args) const;
+
+    /**
+     * Закрытая функция-член класса CompiledExpression
+     * BuildGraph - превращает обратную польскую нотацию в граф с общими подвыражениями
+     * Одинаковые чистые подвыражения заменяются одной вершиной, затем вершинам назначаются регистры,
+     * причем регистр освобождается после последнего использования значения
+     */
+    void BuildGraph();
+
+    /**
+     * Закрытая функция-член класса CompiledExpression
+     * EmitInstructions - назначает вершинам графа регистры и записывает их в instructions для EvalBatch
+     */
+    void EmitInstructions(const vector<Instruction> &nodes, const vector<vector<size_t>> &nodeOperands);
+
+    /**
+     * Закрытая функция-член класса CompiledExpression
+     * EmitCommands - переводит граф в байт-код для Eval
+     * Встроенные операции получают свои команды, константные операнды и пары вершин
+     * (умножение и сложение, возведение в степень и унарный минус) объединяются в составные команды
+     */
+    void EmitCommands(const vector<Instruction> &nodes, const vector<vector<size_t>> &nodeOperands);
+
+public:
+
+    /**
+     * Функция-член класса CompiledExpression
+     * Eval - возвращает вычисленное значение математического выражения без переменных
+     */
+    Fraction Eval() const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * Eval - возвращает вычисленное значение математического выражения
+     * values - значения переменных, values[i] соответствует переменной GetVariables()[i]
+     */
+    Fraction Eval(span<const Fraction> values) const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * Eval - то же, что Eval(values), но регистры и аргументы функций берутся из рабочей памяти arena
+     * Если arena уже размечена под это выражение, вычисление не выделяет память в куче
+     * Eval(values) использует рабочую память своего потока, а при вложенном вызове из функции - временную
+     */
+    Fraction Eval(span<const Fraction> values, EvaluationArena &arena) const;
+
+    /**
+     * Шаблонная функция-член класса CompiledExpression
+     * EvalAs - возвращает значение математического выражения, вычисленное в числах типа Number
+     * values - значения переменных, values[i] соответствует переменной GetVariables()[i]
+     * Number - double, long double, Interval или Fraction. Для double и long double встроенные операции и функции
+     * вычисляются прямо в этом типе без перевода в Fraction, ошибки вычисления дают inf или nan,
+     * операции пользователя вызываются через Fraction. Для Fraction вычисление совпадает с Eval
+     * Для Interval каждая переменная - интервал, а ответ содержит все значения выражения на точках этих
+     * интервалов, в которых оно определено; операции пользователя принимают только интервалы из одной точки
+     */
+    template<typename Number>
+    Number EvalAs(span<const Number> values) const;
+
+    /**
+     * Поле класса CompiledExpression
+     * Extremum - структура результата поиска глобального минимума или максимума
+     *  value - интервал, который гарантированно содержит минимум (максимум) выражения в области поиска
+     *  point - значения переменных в лучшей найденной точке, ее значение - граница value со стороны, обратной поиску
+     *  numberOfBoxes - количество подобластей, на которых было вычислено выражение
+     */
+    struct Extremum {
+        Interval value;
+        vector<long double> point;
+        size_t numberOfBoxes;
+    };
+
+    /**
+     * Функции-члены класса CompiledExpression
+     * FindMinimum, FindMaximum - ищут глобальный минимум и максимум выражения в области box методом ветвей и границ
+     * box - конечные интервалы переменных, box[i] соответствует переменной GetVariables()[i]
+     * Подобласть с наименьшей интервальной оценкой делится пополам по самой широкой переменной, а подобласти,
+     * чья оценка хуже значения в лучшей найденной точке, отбрасываются без вычисления в точках
+     * Поиск заканчивается, когда ширина value не больше tolerance или рассмотрено maxNumberOfBoxes подобластей
+     */
+    Extremum FindMinimum(span<const Interval> box, long double tolerance = 1e-6L,
+                         size_t maxNumberOfBoxes = 100000) const;
+
+    Extremum FindMaximum(span<const Interval> box, long double tolerance = 1e-6L,
+                         size_t maxNumberOfBoxes = 100000) const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * EvalExact - возвращает точное значение математического выражения без переменных
+     */
+    BigRational EvalExact() const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * EvalExact - возвращает точное значение математического выражения, числа любой длины не округляются
+     * values - значения переменных, values[i] соответствует переменной GetVariables()[i]
+     * Операции без точной реализации (тригонометрия, функции пользователя) вычисляются через Fraction
+     */
+    BigRational EvalExact(span<const BigRational> values) const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * GetVariables - возвращает имена переменных в порядке их ячеек
+     */
+    const vector<string> &GetVariables() const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * GetVariableIndex - возвращает номер ячейки переменной по ее имени
+     */
+    size_t GetVariableIndex(const string &name) const;
+
+    /**
+     * Статическая функция-член класса CompiledExpression
+     * ToLowerName - приводит имя к нижнему регистру так же, как разбор выражения: меняются только латинские
+     * буквы ASCII, поэтому результат не зависит от локали
+     */
+    static string ToLowerName(const string &name);
+
+    /**
+     * Функция-член класса CompiledExpression
+     * EvalBatch - вычисляет выражение для каждой строки таблицы, хранящейся по столбцам
+     * columns[i] - столбец значений переменной GetVariables()[i], result - столбец ответов, его размер равен числу строк
+     * Вычисление ведется в double блоками по BatchKernels::blockSize строк,
+     * поэтому строки с ошибкой вычисления (деление на ноль, выход из области определения) получают inf или nan
+     */
+    void EvalBatch(span<const double *const> columns, span<double> result) const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * EvalBatch - то же, что EvalBatch без пула, но блоки строк вычисляются параллельно потоками pool
+     * Ответы совпадают с однопоточным вычислением
+     */
+    void EvalBatch(span<const double *const> columns, span<double> result, ThreadPool &pool) const;
+
+    /**
+     * Функция-член класса CompiledExpression
+     * GetNumberOfDeduplicatedNodes - возвращает количество повторных подвыражений, которые вычисляются один раз
+     */
+    size_t GetNumberOfDeduplicatedNodes() const;
+};
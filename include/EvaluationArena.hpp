@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "Fraction.hpp"
+
+using namespace std;
+
+/**
+ * Класс рабочей памяти вычисления
+ * Хранит регистры байт-кода и буфер аргументов функций для CompiledExpression::Eval
+ * Память только растет: после первого вычисления выражения повторные вычисления не выделяют память
+ * Одну рабочую память нельзя использовать одновременно из нескольких потоков
+ */
+class EvaluationArena {
+private:
+
+    /**
+     * Дружественный класс CompiledExpression
+     * CompiledExpression::Eval размечает рабочую память под свой байт-код
+     */
+    friend class CompiledExpression;
+
+    /**
+     * Поле класса EvaluationArena
+     * registers - хранит регистры байт-кода
+     */
+    vector<Fraction> registers;
+
+    /**
+     * Поле класса EvaluationArena
+     * args - хранит аргументы вызываемой функции, его емкость не меньше наибольшего числа аргументов
+     */
+    vector<Fraction> args;
+
+    /**
+     * Поле класса EvaluationArena
+     * isBusy - хранит true, пока идет вычисление, которое использует эту рабочую память
+     */
+    bool isBusy = false;
+
+    /**
+     * Закрытая функция-член класса EvaluationArena
+     * Reserve - увеличивает память до numberOfRegisters регистров и numberOfArguments аргументов, если ее не хватает
+     */
+    void Reserve(size_t numberOfRegisters, size_t numberOfArguments);
+
+public:
+
+    /**
+     * Конструктор по умолчанию класса EvaluationArena
+     */
+    EvaluationArena() = default;
+
+    /**
+     * Функция-член класса EvaluationArena
+     * IsBusy - возвращает true, если рабочая память сейчас используется вычислением
+     */
+    bool IsBusy() const;
+};
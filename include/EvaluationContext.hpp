@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "Operations.hpp"
+
+using namespace std;
+
+/**
+ * Класс контекста вычисления
+ * Хранит собственный реестр операций и функций, например для одного клиента сервиса
+ * Реестр контекста лежит поверх снимка общего реестра Operations, взятого при создании контекста:
+ * встроенные операции не копируются, в контексте хранятся только добавленные в него операции
+ * Операции контекста не видны в Operations и в других контекстах, а операции, добавленные в Operations
+ * после создания контекста, не видны в контексте
+ * Выражения разбираются по контексту через MathExpression(expression, context)
+ */
+class EvaluationContext {
+private:
+
+    /**
+     * Дружественный класс MathExpression
+     * MathExpression берет снимок реестра контекста при создании
+     */
+    friend class MathExpression;
+
+    /**
+     * Поле класса EvaluationContext
+     * operations - хранит реестр контекста
+     */
+    Operations operations;
+
+public:
+
+    /**
+     * Конструктор по умолчанию класса EvaluationContext
+     * Создает контекст поверх текущего снимка Operations
+     */
+    EvaluationContext();
+
+    /**
+     * Копирующий конструктор и присваивание класса EvaluationContext запрещены
+     */
+    EvaluationContext(const EvaluationContext &) = delete;
+
+    EvaluationContext &operator=(const EvaluationContext &) = delete;
+
+    /**
+     * Функция-член класса EvaluationContext
+     * AddBinaryOperation - добавляет бинарную операцию в контекст, параметры те же, что у Operations
+     */
+    void AddBinaryOperation(const string &name, const function<Fraction(const Fraction &, const Fraction &)> &func,
+                            int priority = 3, bool isPure = false);
+
+    /**
+     * Функция-член класса EvaluationContext
+     * AddUnaryOperation - добавляет унарную операцию в контекст, параметры те же, что у Operations
+     */
+    void AddUnaryOperation(const string &name, const function<Fraction(const Fraction &)> &func, int priority = 3,
+                           bool isPure = false);
+
+    /**
+     * Функция-член класса EvaluationContext
+     * AddFunction - добавляет функцию в контекст, параметры те же, что у Operations
+     */
+    void AddFunction(const string &name, const function<Fraction(const vector<Fraction> &)> &func, int priority = 3,
+                     int numberOfArguments = 0, bool isPure = false);
+
+    /**
+     * Функции-члены класса EvaluationContext
+     * IsBinaryOperation, IsUnaryOperation, IsFunction - проверяют имя среди операций и функций контекста
+     */
+    bool IsBinaryOperation(const string &name);
+
+    bool IsUnaryOperation(const string &name);
+
+    bool IsFunction(const string &name);
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "CompiledExpression.hpp"
+
+using namespace std;
+
+/**
+ * Класс кэша скомпилированных выражений
+ * Ключ - текст выражения без лишних пробелов, значение - общий неизменяемый CompiledExpression
+ * Кэш разбит на сегменты со своими мьютексами, внутри сегмента старые записи вытесняются по LRU
+ * Запись помнит номер снимка реестра операций, по которому выражение скомпилировано: после добавления
+ * операции или функции запись считается устаревшей и при следующем обращении компилируется заново
+ */
+class ExpressionCache {
+private:
+
+    /**
+     * Поле класса ExpressionCache
+     * Entry - структура записи кэша
+     *  key - нормализованный текст выражения
+     *  version - номер снимка реестра операций, взятого перед компиляцией
+     *  compiled - скомпилированное выражение
+     */
+    struct Entry {
+        string key;
+        size_t version;
+        shared_ptr<const CompiledExpression> compiled;
+    };
+
+    /**
+     * Поле класса ExpressionCache
+     * Shard - структура сегмента кэша
+     */
+    struct Shard {
+
+        /**
+         * Поле структуры Shard
+         * lock - защищает order и entries
+         */
+        mutex lock;
+        /**
+         * Поле структуры Shard
+         * order - хранит записи от недавно использованных к давно использованным
+         */
+        list<Entry> order;
+        /**
+         * Поле структуры Shard
+         * entries - хранит словарь от ключа к записи в order
+         */
+        unordered_map<string, list<Entry>::iterator> entries;
+    };
+
+    /**
+     * Поле класса ExpressionCache
+     * shards - хранит сегменты кэша
+     */
+    vector<Shard> shards;
+
+    /**
+     * Поле класса ExpressionCache
+     * capacityOfShard - хранит наибольшее количество записей в одном сегменте
+     */
+    size_t capacityOfShard;
+
+    /**
+     * Поля класса ExpressionCache
+     * hits, misses, evictions - счетчики попаданий, промахов и вытеснений
+     */
+    atomic<size_t> hits = 0;
+    atomic<size_t> misses = 0;
+    atomic<size_t> evictions = 0;
+
+public:
+
+    /**
+     * Конструктор класса ExpressionCache
+     * capacity - наибольшее общее количество записей, numberOfShards - количество сегментов
+     */
+    explicit ExpressionCache(size_t capacity = 4096, size_t numberOfShards = 16);
+
+    /**
+     * Функция-член класса ExpressionCache
+     * Get - возвращает скомпилированное выражение, при промахе или устаревшей записи компилирует его и кэширует
+     * Выражения с ошибками не кэшируются, исключение передается вызывающему
+     */
+    shared_ptr<const CompiledExpression> Get(const string &expression);
+
+    /**
+     * Функция-член класса ExpressionCache
+     * Clear - удаляет все записи, счетчики не сбрасываются
+     */
+    void Clear();
+
+    /**
+     * Функция-член класса ExpressionCache
+     * GetSize - возвращает текущее количество записей
+     */
+    size_t GetSize();
+
+    /**
+     * Функции-члены класса ExpressionCache
+     * GetHits, GetMisses, GetEvictions - возвращают значения счетчиков
+     */
+    size_t GetHits() const;
+
+    size_t GetMisses() const;
+
+    size_t GetEvictions() const;
+
+    /**
+     * Статическая функция-член класса ExpressionCache
+     * Normalize - удаляет пробельные символы, кроме одного пробела между двумя частями слов или чисел
+     * Например "1 + 20" и "1+20" дают один ключ, а "2 4" не превращается в "24"
+     */
+    static string Normalize(const string &expression);
+};
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cmath>
+#include <algorithm>
 #include <limits>
 #include <stdexcept>
 
@@ -9,16 +11,13 @@ using namespace std;
 
 /**
  * Класс обыкновенных дробей
+ * Арифметика ведется в __int128 с проверкой переполнения, знаменатель всегда положителен
+ * Дробь сокращается лениво: только когда результат не помещается в long long
+ * Число с плавающей точкой переводится в ближайшую несократимую дробь с ограниченной погрешностью и знаменателем
  */
 class Fraction {
 private:
 
-    /**
-     * Поле класса Fraction
-     * precision - хранит точность (степень 10)
-     */
-    const long long precision = 1000000000;
-
     /**
      * Поле класса Fraction
      * numerator - хранит числитель дроби
@@ -33,9 +32,27 @@ private:
     /**
      * Закрытая функция-член класса Fraction
      * GCD - возвращает наибольший общий делитель
-     * Применяется алгоритм Евклида
+     * Применяется двоичный алгоритм (алгоритм Стейна): вместо деления - сдвиги и вычитание
      */
-    static long long GCD(long long a, long long b);
+    static unsigned long long GCD(unsigned long long a, unsigned long long b);
+
+    static unsigned __int128 GCD(unsigned __int128 a, unsigned __int128 b);
+
+    /**
+     * Закрытая функция-член класса Fraction
+     * Make - возвращает дробь numerator / denominator, denominator не равен нулю
+     * Знак переносится в числитель, дробь сокращается, только если не помещается в long long,
+     * а если не помещается и после сокращения - заменяется ближайшей дробью Round
+     * Если ненулевая дробь так мала, что ближайшей оказывается 0, выбрасывает исключение
+     */
+    static Fraction Make(__int128 numerator, __int128 denominator);
+
+    /**
+     * Закрытая функция-член класса Fraction
+     * Round - возвращает ближайшую к numerator / denominator дробь с числителем и знаменателем long long,
+     * denominator больше нуля. Дробь ищется по подходящим дробям цепной дроби в целых числах без округления
+     */
+    static Fraction Round(__int128 numerator, __int128 denominator);
 
     /**
      * Закрытая функция-член класса Fraction
@@ -50,16 +67,126 @@ public:
      */
     explicit Fraction();
 
+    /**
+     * Поля класса Fraction
+     * defaultMaxError - наибольшая относительная погрешность перевода числа в дробь по умолчанию
+     * defaultMaxDenominator - наибольший знаменатель такой дроби по умолчанию
+     */
+    static constexpr long double defaultMaxError = 1e-9L;
+    static constexpr long long defaultMaxDenominator = 1000000000000000000;
+
     /**
      * Конструктор с числовым аргументом класса Fraction
+     * Число переводится в дробь с погрешностью defaultMaxError и знаменателем не больше defaultMaxDenominator
      */
     explicit Fraction(const long double &number);
 
+    /**
+     * Конструктор с числовым аргументом класса Fraction
+     * Возвращает дробь с наименьшим знаменателем, которая отличается от number не больше чем на maxError * |number|,
+     * или, если такой нет, ближайшую к number дробь со знаменателем не больше maxDenominator
+     * Дробь ищется по подходящим дробям цепной дроби number (спуск по дереву Штерна - Броко)
+     */
+    Fraction(const long double &number, long double maxError, long long maxDenominator);
+
     /**
      * Конструктор со строковым аргументом класса Fraction
+     * Строка целиком должна быть десятичной записью числа в формате ScanDecimal
      */
     explicit Fraction(const string &str);
 
+    /**
+     * Поле класса Fraction
+     * Decimal - структура десятичной записи числа, разобранной ScanDecimal: значение равно mantissa * 10^exponent
+     */
+    struct Decimal {
+
+        /**
+         * Поля структуры Decimal
+         * mantissa - цифры числа без точки, помещается в long long
+         * exponent - десятичный порядок с учетом точки и показателя степени
+         */
+        unsigned long long mantissa = 0;
+        long long exponent = 0;
+        /**
+         * Поле структуры Decimal
+         * length - количество разобранных символов
+         */
+        size_t length = 0;
+        /**
+         * Поля структуры Decimal
+         * isValid - false, если в записи нет цифр или больше одной точки
+         * isTruncated - true, если не поместившиеся в mantissa ненулевые цифры были отброшены
+         */
+        bool isValid = false;
+        bool isTruncated = false;
+    };
+
+    /**
+     * Статическая функция-член класса Fraction
+     * ScanDecimal - разбирает число в начале text за один проход: цифры с не более чем одной точкой и необязательный
+     * показатель степени вида e-2 (E+2, e2), показатель разбирается, только если за 'e' и знаком идет цифра
+     * Цифры сразу накапливаются в mantissa, поэтому промежуточные строки не создаются
+     * Функция constexpr, чтобы числа StaticExpression разбирались при компиляции по тем же правилам
+     */
+    static constexpr Decimal ScanDecimal(string_view text) {
+        const unsigned long long maxMantissa = numeric_limits<long long>::max();
+        // Больший порядок все равно не помещается ни в Fraction, ни в разумное BigRational
+        const long long maxExponent = 1000000;
+
+        Decimal decimal;
+        size_t &position = decimal.length;
+        size_t numberOfDigits = 0, numberOfPoints = 0;
+
+        for (; position < text.size() && ((text[position] >= '0' && text[position] <= '9') || text[position] == '.');
+               position++) {
+            if (text[position] == '.') {
+                numberOfPoints++;
+                continue;
+            }
+
+            auto digit = (unsigned long long) (text[position] - '0');
+            numberOfDigits++;
+
+            if (decimal.mantissa <= (maxMantissa - digit) / 10) {
+                decimal.mantissa = decimal.mantissa * 10 + digit;
+                if (numberOfPoints != 0) decimal.exponent--;
+            } else {
+                // Лишняя цифра отбрасывается, в целой части она увеличивает порядок
+                if (numberOfPoints == 0) decimal.exponent++;
+                if (digit != 0) decimal.isTruncated = true;
+            }
+        }
+
+        decimal.isValid = (numberOfDigits != 0 && numberOfPoints <= 1);
+
+        if (decimal.isValid && position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+            size_t next = position + 1;
+            bool isNegative = false;
+
+            if (next < text.size() && (text[next] == '+' || text[next] == '-')) isNegative = (text[next++] == '-');
+
+            if (next < text.size() && text[next] >= '0' && text[next] <= '9') {
+                long long exponent = 0;
+                for (; next < text.size() && text[next] >= '0' && text[next] <= '9'; next++)
+                    exponent = min(exponent * 10 + (text[next] - '0'), maxExponent);
+
+                decimal.exponent += (isNegative ? -exponent : exponent);
+                position = next;
+            }
+        }
+
+        return decimal;
+    }
+
+    /**
+     * Статическая функция-член класса Fraction
+     * FromDecimal - возвращает дробь, равную decimal
+     * Если знаменатель 10^-exponent помещается в long long, а цифры не отбрасывались, дробь точная
+     * Если число не помещается в long long, выбрасывает исключение
+     */
+    static Fraction FromDecimal(const Decimal &decimal);
+
     /**
      * Функция-член класса Fraction
      * GetNumerator - возвращает числитель дроби
@@ -129,6 +256,8 @@ public:
     /**
      * Функция-член класса Fraction
      * Power - возводит дробь в дробную степень и возвращает полученную дробь
+     * Целая степень и степень с целым корнем из основания вычисляются точно возведением в квадрат,
+     * а если результат не помещается в long long или корень не целый - в long double
      */
     static Fraction Power(const Fraction &a, const Fraction &b);
 };
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "BigRational.hpp"
+#include "BatchKernels.hpp"
+
+using namespace std;
+
+/**
+ * Класс интервалов чисел long double
+ * Результат каждой операции содержит все значения операции на точках интервалов-аргументов:
+ * границы округляются наружу (нижняя - вниз, верхняя - вверх) на несколько единиц последнего разряда
+ * Точки, в которых операция не определена (sqrt(-1), деление на 0, arccos(2)), не дают значений,
+ * поэтому интервал может быть пустым, а пустой аргумент дает пустой результат
+ */
+class Interval {
+private:
+
+    /**
+     * Поля класса Interval
+     * lower, upper - нижняя и верхняя границы, у пустого интервала lower больше upper
+     */
+    long double lower;
+    long double upper;
+
+    /**
+     * Закрытая статическая функция-член класса Interval
+     * Outward - возвращает интервал [lower, upper], расширенный наружу на numberOfUlps единиц последнего разряда
+     * Если границы равны nan, возвращает всю числовую прямую
+     */
+    static Interval Outward(long double lower, long double upper, int numberOfUlps);
+
+    /**
+     * Закрытая статическая функция-член класса Interval
+     * IntegerPower - возводит a в целую степень n
+     */
+    static Interval IntegerPower(const Interval &a, long long n);
+
+    /**
+     * Закрытая статическая функция-член класса Interval
+     * NonNegativePower - возводит неотрицательный a в степень b через значения в углах области
+     * При a >= 0 степень монотонна по каждому аргументу, поэтому наименьшее и наибольшее значения лежат в углах
+     */
+    static Interval NonNegativePower(const Interval &a, const Interval &b);
+
+public:
+
+    /**
+     * Конструктор по умолчанию класса Interval
+     * Создает интервал [0, 0]
+     */
+    Interval() : lower(0), upper(0) {}
+
+    /**
+     * Конструктор с числовым аргументом класса Interval
+     * Создает интервал из одной точки value
+     */
+    explicit Interval(long double value) : lower(value), upper(value) {}
+
+    /**
+     * Конструктор класса Interval
+     * Создает интервал [lower, upper], если lower больше upper или граница равна nan, выбрасывает исключение
+     */
+    Interval(long double lower, long double upper);
+
+    /**
+     * Конструктор с аргументом BigRational класса Interval
+     * Создает интервал с границами long double, который гарантированно содержит value
+     */
+    explicit Interval(const BigRational &value);
+
+    /**
+     * Статические функции-члены класса Interval
+     * Empty - возвращает пустой интервал, Entire - всю числовую прямую
+     */
+    static Interval Empty();
+
+    static Interval Entire();
+
+    /**
+     * Функции-члены класса Interval
+     * GetLower, GetUpper - возвращают границы интервала
+     */
+    long double GetLower() const;
+
+    long double GetUpper() const;
+
+    /**
+     * Функции-члены класса Interval
+     * IsEmpty - возвращает true, если интервал пустой
+     * IsPoint - возвращает true, если интервал состоит из одной точки
+     */
+    bool IsEmpty() const;
+
+    bool IsPoint() const;
+
+    /**
+     * Функции-члены класса Interval
+     * GetWidth - возвращает ширину интервала, GetMiddle - его середину
+     */
+    long double GetWidth() const;
+
+    long double GetMiddle() const;
+
+    /**
+     * Функция-член класса Interval
+     * Contains - возвращает true, если value лежит в интервале
+     */
+    bool Contains(long double value) const;
+
+    /**
+     * Перегрузка операторов
+     * Деление на интервал, содержащий 0, дает интервал, содержащий значения на точках делителя кроме 0
+     */
+
+    Interval operator+(const Interval &other) const;
+
+    Interval operator-(const Interval &other) const;
+
+    Interval operator-() const;
+
+    Interval operator*(const Interval &other) const;
+
+    Interval operator/(const Interval &other) const;
+
+    /**
+     * Статическая функция-член класса Interval
+     * Hull - возвращает наименьший интервал, содержащий a и b
+     */
+    static Interval Hull(const Interval &a, const Interval &b);
+
+    /**
+     * Статическая функция-член класса Interval
+     * Power - возводит a в степень b по правилам BatchKernels::Power: целая степень - для любого основания,
+     * дробная степень с нечетным знаменателем (1/3) - и для отрицательного основания, остальные - для a >= 0
+     * Узкий показатель, отличающийся от дроби с небольшим знаменателем меньше погрешности, считается равным ей
+     */
+    static Interval Power(const Interval &a, const Interval &b);
+
+    /**
+     * Статические функции-члены класса Interval
+     * Apply - применяет ядро встроенной унарной операции или функции одного аргумента (Apply(kernel, a))
+     * либо бинарной операции (Apply(kernel, a, b)) к интервалам, как BatchKernels::Apply к числам
+     * Для ядра generic выбрасывает исключение: у операций пользователя нет интервального вычисления
+     */
+    static Interval Apply(BatchKernels::TypeOfKernels kernel, const Interval &a);
+
+    static Interval Apply(BatchKernels::TypeOfKernels kernel, const Interval &a, const Interval &b);
+};
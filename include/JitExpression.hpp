@@ -0,0 +1,113 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "CompiledExpression.hpp"
+
+using namespace std;
+
+/**
+ * Класс выражения, переведенного в машинный код x86-64
+ * Программа CompiledExpression переводится в функцию, которая вычисляет выражение сразу для двух строк
+ * упакованными инструкциями SSE2 над double, встроенные функции вызываются напрямую
+ * Если в выражении есть операция без ядра (пользовательская) или платформа не x86-64,
+ * вычисление передается интерпретатору CompiledExpression::EvalBatch
+ * После создания объект не изменяется, поэтому вычисления можно вызывать одновременно из нескольких потоков
+ */
+class JitExpression {
+private:
+
+    /**
+     * Поле класса JitExpression
+     * compiled - хранит скомпилированное выражение, по нему вычисляет интерпретатор, если машинного кода нет
+     */
+    CompiledExpression compiled;
+
+    /**
+     * Поле класса JitExpression
+     * Code - тип сгенерированной функции
+     * columns - столбцы переменных, result - ответы, size - количество строк (четное),
+     * registers - память под регистры программы, по два double на регистр
+     */
+    using Code = void (*)(const double *const *columns, double *result, size_t size, double *registers);
+
+    /**
+     * Поля класса JitExpression
+     * memory, sizeOfMemory - хранят исполняемую память с машинным кодом, nullptr - если кода нет
+     */
+    void *memory = nullptr;
+    size_t sizeOfMemory = 0;
+
+    /**
+     * Поле класса JitExpression
+     * code - хранит точку входа машинного кода
+     */
+    Code code = nullptr;
+
+    /**
+     * Закрытая функция-член класса JitExpression
+     * Generate - переводит программу в машинный код, возвращает пустой массив, если какую-то инструкцию перевести нельзя
+     */
+    vector<uint8_t> Generate() const;
+
+    /**
+     * Закрытая функция-член класса JitExpression
+     * WritePerfMap - добавляет запись о машинном коде в /tmp/perf-<pid>.map, чтобы perf подписывал его отсчеты
+     */
+    void WritePerfMap() const;
+
+public:
+
+    /**
+     * Конструктор класса JitExpression
+     * Переводит выражение в машинный код, при неудаче остается вычисление интерпретатором
+     */
+    explicit JitExpression(const CompiledExpression &expression);
+
+    /**
+     * Деструктор класса JitExpression
+     * Освобождает исполняемую память
+     */
+    ~JitExpression();
+
+    /**
+     * Копирующий конструктор и присваивание класса JitExpression запрещены, исполняемая память не разделяется
+     */
+    JitExpression(const JitExpression &) = delete;
+
+    JitExpression &operator=(const JitExpression &) = delete;
+
+    /**
+     * Функция-член класса JitExpression
+     * IsCompiled - возвращает true, если выражение вычисляется машинным кодом, иначе - false
+     */
+    bool IsCompiled() const;
+
+    /**
+     * Функция-член класса JitExpression
+     * Eval - вычисляет выражение для одной строки, values[i] соответствует переменной GetVariables()[i]
+     */
+    double Eval(span<const double> values) const;
+
+    /**
+     * Функция-член класса JitExpression
+     * EvalBatch - вычисляет выражение для всех строк, columns[i] соответствует переменной GetVariables()[i]
+     * Результаты совпадают с CompiledExpression::EvalBatch
+     */
+    void EvalBatch(span<const double *const> columns, span<double> result) const;
+
+    /**
+     * Функция-член класса JitExpression
+     * GetVariables - возвращает имена переменных в порядке их столбцов
+     */
+    const vector<string> &GetVariables() const;
+
+    /**
+     * Статическая функция-член класса JitExpression
+     * SetPerfMapEnabled - включает запись /tmp/perf-<pid>.map для выражений, создаваемых после вызова
+     */
+    static void SetPerfMapEnabled(bool isEnabled);
+};
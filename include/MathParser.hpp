@@ -3,9 +3,13 @@
 #include <stack>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
 
 #include "Operations.hpp"
+#include "EvaluationContext.hpp"
 #include "Fraction.hpp"
+#include "CompiledExpression.hpp"
 
 using namespace std;
 
@@ -18,9 +22,10 @@ private:
 
     /**
      * Поле класса MathExpression
-     * operations - хранит экземпляр класса Operations
+     * operations - хранит снимок реестра Operations или контекста, взятый при создании выражения
+     * Токены ссылаются на описания снимка, поэтому операции, добавленные позже, на выражение не влияют
      */
-    Operations &operations = Operations::GetInstance();
+    shared_ptr<const Operations::Snapshot> operations;
     /**
      * Поле класса MathExpression
      * expression - хранит введенное математическое выражение
@@ -37,7 +42,7 @@ private:
      * TypeOfTokens - перечисление типов токенов
      */
     enum TypeOfTokens {
-        unknown, number, comma, openBracket, closeBracket, binaryOperation, unaryOperation, func
+        unknown, number, variable, comma, openBracket, closeBracket, binaryOperation, unaryOperation, func
     };
 
     /**
@@ -47,20 +52,52 @@ private:
     struct Token {
 
         /**
-         * Поле структуры Token
-         * name - хранит имя токена
+         * Поля структуры Token
+         * offset, length - хранят положение и длину токена в строке expression, сам текст токена не копируется
          */
-        string name;
+        size_t offset;
+        size_t length;
         /**
          * Поле структуры Token
          * type - хранит тип токена
          */
         TypeOfTokens type;
+        /**
+         * Поле структуры Token
+         * numberOfArguments - хранит количество аргументов функции (для скобки - количество запятых внутри нее)
+         */
+        size_t numberOfArguments;
+        /**
+         * Поле структуры Token
+         * priority - хранит приоритет операции или функции
+         */
+        int priority;
+        /**
+         * Поля структуры Token
+         * binary, unary, function - хранят описание операции или функции, найденное при разборе токена
+         * Заполнено только поле, соответствующее типу токена
+         */
+        const Operations::BinaryOperation *binary;
+        const Operations::UnaryOperation *unary;
+        const Operations::Function *function;
+        /**
+         * Поле структуры Token
+         * value - хранит значение числа, вычисленное при разборе токена
+         */
+        Fraction value;
+        /**
+         * Поля структуры Token
+         * isExact - true, если value равно записи числа точно
+         * isLarge - true, если число не помещается в Fraction и value не заполнено
+         */
+        bool isExact;
+        bool isLarge;
 
         /**
          * Конструктор по умолчанию структуры Token
          */
-        Token() : type(unknown) {}
+        Token() : offset(0), length(0), type(unknown), numberOfArguments(0), priority(0), binary(nullptr), unary(nullptr),
+                  function(nullptr), value(), isExact(false), isLarge(false) {}
     };
 
     /**
@@ -70,60 +107,102 @@ private:
     vector<Token> postfixNotationExpression;
 
     /**
-     * Закрытая функция-член класса MathExpression
-     * GetTokenType - возвращает тип операции
+     * Поле класса MathExpression
+     * previousTokenType - хранит тип предыдущего токена, по нему унарная операция отличается от бинарной
+     */
+    TypeOfTokens previousTokenType = unknown;
+    /**
+     * Поле класса MathExpression
+     * numberOfOpenBrackets - хранит количество открытых и еще не закрытых скобок, проверяется во время разбора
      */
-    TypeOfTokens GetTokenType(size_t position, const string &name);
+    size_t numberOfOpenBrackets = 0;
 
     /**
      * Закрытая функция-член класса MathExpression
-     * Функция-член для получения следующего токена
+     * GetName - возвращает текст токена в строке expression
      */
-    Token GetToken();
+    string_view GetName(const Token &token) const;
 
     /**
      * Закрытая функция-член класса MathExpression
-     * Функция-член для построения обратной польской нотации
+     * GetSymbolClass - возвращает набор классов символа (цифра, точка, буква, '_', пробел) по таблице,
+     * за концом строки - пустой набор
      */
-    void BuildPostfixNotation();
+    uint8_t GetSymbolClass(size_t position) const;
 
     /**
      * Закрытая функция-член класса MathExpression
-     * IsDigit - возвращает true, если символ является цифрой, иначе - false
+     * GetTokenType - возвращает тип операции
+     * Для операций и функций заполняет в token найденное описание и приоритет
+     * descriptor - запись реестра Operations для имени токена, nullptr - если имени в реестре нет
      */
-    bool IsDigit(const size_t &position);
+    TypeOfTokens GetTokenType(size_t position, Token &token, const Operations::Descriptor *descriptor);
 
     /**
      * Закрытая функция-член класса MathExpression
-     * IsPoint - возвращает true, если символ является точкой, иначе - false
+     * Функция-член для получения следующего токена
      */
-    bool IsPoint(const size_t &position);
+    Token GetToken();
 
     /**
      * Закрытая функция-член класса MathExpression
-     * IsLetter - возвращает true, если символ является буквой, иначе - false
+     * Функция-член для построения обратной польской нотации
      */
-    bool IsLetter(const size_t &position);
+    void BuildPostfixNotation();
 
     /**
      * Закрытая функция-член класса MathExpression
-     * IsBracketSequenceCorrect - возвращает true, если скобочная последовательность корректна, иначе - false
+     * Compile - компилирует выражение с заданным порядком переменных
+     * canAddVariables - разрешает добавлять в конец списка переменные, которых в нем нет
+     */
+    CompiledExpression Compile(const vector<string> &variables, bool canAddVariables);
+
+    /**
+     * Закрытый конструктор класса MathExpression
+     * Разбирает выражение по снимку реестра operations
      */
-    bool IsBracketSequenceCorrect();
+    MathExpression(const string &expr, shared_ptr<const Operations::Snapshot> operations);
 
 
 public:
-    explicit MathExpression(const string &expr) {
-        if (expr.empty()) throw runtime_error("Ошибка. Пустое выражение");
+    /**
+     * Конструктор класса MathExpression
+     * Буквы выражения приводятся к нижнему регистру один раз, скобочная последовательность проверяется при разборе
+     */
+    explicit MathExpression(const string &expr);
 
-        expression = expr;
+    /**
+     * Конструктор класса MathExpression
+     * Операции и функции выражения берутся из контекста context, а не из общего реестра Operations
+     * Скомпилированное выражение хранит копии операций и не зависит от дальнейших изменений контекста
+     */
+    MathExpression(const string &expr, const EvaluationContext &context);
 
-        if (!IsBracketSequenceCorrect()) throw runtime_error("Ошибка. Некорректная скобочная последовательность");
-    }
+    /**
+     * Функция-член класса MathExpression
+     * Compile - разбирает выражение один раз и возвращает скомпилированное выражение
+     * Полученный объект можно вычислять многократно без повторного разбора строки
+     * Переменные получают номера ячеек в порядке первого появления в выражении
+     * Части выражения, состоящие только из чисел и чистых операций, вычисляются при компиляции
+     */
+    CompiledExpression Compile();
+
+    /**
+     * Функция-член класса MathExpression
+     * Compile - компилирует выражение, связывая переменные с ячейками в порядке списка variables
+     * Если в выражении встречается переменная, которой нет в списке, выбрасывается исключение
+     */
+    CompiledExpression Compile(const vector<string> &variables);
 
     /**
      * Функция-член класса MathExpression
      * Eval - возвращает вычисленное значение математического выражения
      */
     Fraction Eval();
+
+    /**
+     * Функция-член класса MathExpression
+     * EvalExact - возвращает точное значение математического выражения, числа любой длины не округляются
+     */
+    BigRational EvalExact();
 };
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <functional>
+
+#include "CompiledExpression.hpp"
+
+using namespace std;
+
+/**
+ * Класс модуля машинного кода, собранного заранее
+ * Набор выражений переводится в исходный код C++, который собирается системным компилятором в разделяемую
+ * библиотеку и загружается через dlopen. Библиотека сохраняется в каталоге кэша под именем, зависящим от хеша
+ * исходного кода, компилятора и флагов, поэтому после перезапуска программы повторная сборка не нужна
+ * Операции без ядра (добавленные через Operations) вызываются из библиотеки через таблицу переходов, которая
+ * хранится в модуле и передается функциям выражений при каждом вызове: dlopen возвращает одну и ту же библиотеку
+ * всем модулям с одинаковым путем, поэтому общая таблица в библиотеке связала бы их операции между собой
+ * Вычисление ведется в double, результаты совпадают с CompiledExpression::EvalBatch
+ */
+class NativeModule {
+private:
+
+    /**
+     * Поле класса NativeModule
+     * Trampoline - структура записи таблицы переходов, совпадает со структурой в сгенерированном коде
+     */
+    struct Trampoline {
+        double (*call)(void *context, const double *args, size_t numberOfArguments);
+        void *context;
+    };
+
+    /**
+     * Поле класса NativeModule
+     * Code - тип функции выражения в библиотеке, trampolines - таблица переходов модуля, power - функция степени
+     */
+    using Code = void (*)(const double *const *columns, double *result, size_t size, const Trampoline *trampolines,
+                          double (*power)(double, double));
+
+    /**
+     * Поле класса NativeModule
+     * expressions - хранит скомпилированные выражения модуля
+     */
+    vector<CompiledExpression> expressions;
+
+    /**
+     * Поле класса NativeModule
+     * operations - хранит операции, вызываемые через таблицу переходов, в порядке записей таблицы
+     */
+    vector<function<Fraction(const vector<Fraction> &)>> operations;
+
+    /**
+     * Поле класса NativeModule
+     * trampolines - хранит таблицу переходов модуля, запись с номером i вызывает operations[i]
+     */
+    vector<Trampoline> trampolines;
+
+    /**
+     * Поле класса NativeModule
+     * codes - хранит функции выражений, загруженные из библиотеки
+     */
+    vector<Code> codes;
+
+    /**
+     * Поле класса NativeModule
+     * source - хранит сгенерированный исходный код
+     */
+    string source;
+
+    /**
+     * Поле класса NativeModule
+     * path - хранит путь к библиотеке в каталоге кэша
+     */
+    string path;
+
+    /**
+     * Поле класса NativeModule
+     * handle - хранит дескриптор загруженной библиотеки
+     */
+    void *handle = nullptr;
+
+    /**
+     * Поле класса NativeModule
+     * isLoadedFromCache - хранит true, если библиотека уже была в кэше и сборка не понадобилась
+     */
+    bool isLoadedFromCache = false;
+
+    /**
+     * Закрытая функция-член класса NativeModule
+     * Generate - переводит выражения в исходный код и заполняет operations
+     */
+    void Generate();
+
+    /**
+     * Закрытая функция-член класса NativeModule
+     * Load - загружает библиотеку, заполняет таблицу переходов модуля и находит функции выражений
+     */
+    void Load();
+
+    /**
+     * Закрытая статическая функция-член класса NativeModule
+     * CallTrampoline - вызывает операцию из таблицы переходов, context указывает на элемент operations
+     * Ошибка вычисления дает nan, как в CompiledExpression::EvalBatch
+     */
+    static double CallTrampoline(void *context, const double *args, size_t numberOfArguments);
+
+public:
+
+    /**
+     * Конструктор класса NativeModule
+     * expressions - тексты выражений, cacheDirectory - каталог кэша библиотек, пустая строка - каталог
+     * пользователя GetDefaultCacheDirectory(). Недостающие каталоги создаются с правами 0700, каталог кэша и
+     * библиотека должны принадлежать пользователю и быть закрыты для записи другим, иначе модуль не загружается
+     * compiler и flags - компилятор и его флаги через пробел, они входят в ключ кэша. Компилятор запускается
+     * без командной оболочки
+     */
+    explicit NativeModule(const vector<string> &expressions, const string &cacheDirectory = "",
+                          const string &compiler = "c++", const string &flags = "-std=c++17 -O2 -fPIC -shared");
+
+    /**
+     * Деструктор класса NativeModule
+     * Выгружает библиотеку, файл в кэше остается
+     */
+    ~NativeModule();
+
+    /**
+     * Копирующий конструктор и присваивание класса NativeModule запрещены, библиотека загружается один раз
+     */
+    NativeModule(const NativeModule &) = delete;
+
+    NativeModule &operator=(const NativeModule &) = delete;
+
+    /**
+     * Статическая функция-член класса NativeModule
+     * GetDefaultCacheDirectory - возвращает каталог кэша пользователя: $XDG_CACHE_HOME/mathparser,
+     * а если переменная не задана - ~/.cache/mathparser
+     */
+    static string GetDefaultCacheDirectory();
+
+    /**
+     * Функция-член класса NativeModule
+     * GetNumberOfExpressions - возвращает количество выражений модуля
+     */
+    size_t GetNumberOfExpressions() const;
+
+    /**
+     * Функция-член класса NativeModule
+     * GetVariables - возвращает имена переменных выражения с номером expression в порядке их столбцов
+     */
+    const vector<string> &GetVariables(size_t expression) const;
+
+    /**
+     * Функция-член класса NativeModule
+     * Eval - вычисляет выражение с номером expression для одной строки
+     */
+    double Eval(size_t expression, span<const double> values) const;
+
+    /**
+     * Функция-член класса NativeModule
+     * EvalBatch - вычисляет выражение с номером expression для всех строк
+     */
+    void EvalBatch(size_t expression, span<const double *const> columns, span<double> result) const;
+
+    /**
+     * Функция-член класса NativeModule
+     * GetSource - возвращает сгенерированный исходный код
+     */
+    const string &GetSource() const;
+
+    /**
+     * Функция-член класса NativeModule
+     * GetPath - возвращает путь к библиотеке в каталоге кэша
+     */
+    const string &GetPath() const;
+
+    /**
+     * Функция-член класса NativeModule
+     * IsLoadedFromCache - возвращает true, если библиотека взята из кэша без сборки
+     */
+    bool IsLoadedFromCache() const;
+};
@@ -1,18 +1,25 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cmath>
 #include <map>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <atomic>
 
 #include "Fraction.hpp"
+#include "BatchKernels.hpp"
 
 using namespace std;
 
 /**
  * Класс операций
  * Реализует шаблон проектирования - Singleton
+ * Операции хранятся в неизменяемых снимках (Snapshot): чтение берет ссылку на текущий снимок и не блокирует
+ * добавление операций, а добавление публикует новый снимок, не дожидаясь завершения вычислений
  */
 class Operations {
 private:
@@ -23,128 +30,255 @@ private:
      */
     friend class MathExpression;
 
+    /**
+     * Дружественный класс EvaluationContext
+     * EvaluationContext создает собственный экземпляр Operations поверх общего снимка
+     */
+    friend class EvaluationContext;
+
     /**
      * Поле класса Operations
-     * binaryOperations - хранит словарь бинарных операций:
-     *  Ключ - имя операции типа string
-     *  Значение - лямбда-выражение от двух переменных типа Fraction
-     * Очередность операций: слева направо
-     */
-    map<string, function<Fraction(const Fraction &, const Fraction &)>> binaryOperations = {
-            {"+", [](const Fraction &a, const Fraction &b) { return a + b; }},
-            {"-", [](const Fraction &a, const Fraction &b) { return a - b; }},
-            {"*", [](const Fraction &a, const Fraction &b) { return a * b; }},
-            {"/", [](const Fraction &a, const Fraction &b) { return a / b; }},
-            {"^", [](const Fraction &a, const Fraction &b) { return Fraction::Power(a, b); }},
-            {"e", [](const Fraction &a, const Fraction &b) { return a * Fraction::Power(Fraction(10.0), b); }}
+     * BinaryOperation - структура описания бинарной операции
+     *  func - лямбда-выражение от двух переменных типа Fraction
+     *  priority - приоритет операции
+     *  isPure - операция чистая (результат зависит только от аргументов), ее можно вычислять при компиляции
+     *  kernel - ядро пакетного вычисления, для встроенных операций задается в конструкторе
+     */
+    struct BinaryOperation {
+        function<Fraction(const Fraction &, const Fraction &)> func;
+        int priority;
+        bool isPure = true;
+        BatchKernels::TypeOfKernels kernel = BatchKernels::generic;
     };
 
     /**
      * Поле класса Operations
-     * unaryOperations - хранит словарь унарных операций:
-     *  Ключ - имя операции типа string
-     *  Значение - лямбда-выражение от одной переменной типа Fraction
-     * Очередность операций: слева направо
-     */
-    map<string, function<Fraction(const Fraction &)>> unaryOperations = {
-            {"+", [](const Fraction &a) { return a; }},
-            {"-", [](const Fraction &a) { return -a; }}
+     * UnaryOperation - структура описания унарной операции, поля имеют тот же смысл, что и у BinaryOperation
+     */
+    struct UnaryOperation {
+        function<Fraction(const Fraction &)> func;
+        int priority;
+        bool isPure = true;
+        BatchKernels::TypeOfKernels kernel = BatchKernels::generic;
     };
 
     /**
      * Поле класса Operations
-     * functions - хранит словарь функций:
-     *  Ключ - имя функции типа string
-     *  Значение - лямбда-выражение от одной и более переменной типа Fraction
-     * Очередность функций: слева направо
-     */
-    map<string, function<Fraction(const vector<Fraction> &)>> functions{
-            {"sin",    [](const vector<Fraction> &a) { return Fraction(sin((long double) a[0])); }},
-            {"cos",    [](const vector<Fraction> &a) { return Fraction(cos((long double) a[0])); }},
-            {"tg",     [](const vector<Fraction> &a) { return Fraction(tan((long double) a[0])); }},
-            {"tan",    [](const vector<Fraction> &a) { return Fraction(tan((long double) a[0])); }},
-            {"ctg",    [](const vector<Fraction> &a) {
-                return Fraction(cos((long double) a[0]) / sin((long double) a[0]));
-            }},
-            {"arcsin", [](const vector<Fraction> &a) { return Fraction(asin((long double) a[0])); }},
-            {"arccos", [](const vector<Fraction> &a) { return Fraction(acos((long double) a[0])); }},
-            {"arctg",  [](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }},
-            {"arctan", [](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }},
-            {"arcctg", [](const vector<Fraction> &a) { return Fraction(M_PI_2 - atan((long double) a[0])); }},
-            {"asin",   [](const vector<Fraction> &a) { return Fraction(asin((long double) a[0])); }},
-            {"acos",   [](const vector<Fraction> &a) { return Fraction(acos((long double) a[0])); }},
-            {"atg",    [](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }},
-            {"atan",   [](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }},
-            {"actg",   [](const vector<Fraction> &a) { return Fraction(M_PI_2 - atan((long double) a[0])); }},
-            {"abs",    [](const vector<Fraction> &a) { return Fraction(abs((long double) a[0])); }},
-            {"int",    [](const vector<Fraction> &a) { return Fraction(floor((long double) a[0])); }},
-            {"sqrt",   [](const vector<Fraction> &a) { return Fraction::Power(a[0], Fraction(0.5)); }}
+     * Function - структура описания функции, поля имеют тот же смысл, что и у BinaryOperation
+     *  numberOfArguments - количество аргументов, если равно 0, то неограниченное количество
+     */
+    struct Function {
+        function<Fraction(const vector<Fraction> &)> func;
+        int priority;
+        int numberOfArguments;
+        bool isPure = true;
+        BatchKernels::TypeOfKernels kernel = BatchKernels::generic;
     };
 
     /**
      * Поле класса Operations
-     * numberOfFunctionArguments - хранит словарь количества аргументов функций:
-     *  Ключ - имя функции типа string
-     *  Значение - количество аргументов типа int
-     */
-    map<string, int> numberOfFunctionArguments{
-            {"sin",    1},
-            {"cos",    1},
-            {"tg",     1},
-            {"tan",    1},
-            {"ctg",    1},
-            {"arcsin", 1},
-            {"arccos", 1},
-            {"arctg",  1},
-            {"arctan", 1},
-            {"arcctg", 1},
-            {"asin",   1},
-            {"acos",   1},
-            {"atg",    1},
-            {"atan",   1},
-            {"actg",   1},
-            {"abs",    1},
-            {"int",    1},
-            {"sqrt",   1}
+     * Descriptor - структура записи реестра имен
+     *  name - имя операции или функции, пустое - свободная ячейка
+     *  hash - хеш имени
+     *  binary, unary, function - описания операций и функции с этим именем, nullptr - если такой нет
+     */
+    struct Descriptor {
+        string name;
+        size_t hash = 0;
+        const BinaryOperation *binary = nullptr;
+        const UnaryOperation *unary = nullptr;
+        const Function *function = nullptr;
     };
 
     /**
      * Поле класса Operations
-     * priorities - хранит словарь приоритетов для операций и функций:
-     *  Ключ - имя операции/функции типа string
-     *  Значение - приоритет операции типа int
-     */
-    map<string, int> priorities = {
-            {"+",      1},
-            {"-",      1},
-            {"*",      2},
-            {"/",      2},
-            {"^",      3},
-            {"e",      3},
-            {"sin",    3},
-            {"cos",    3},
-            {"tg",     3},
-            {"tan",    3},
-            {"ctg",    3},
-            {"arcsin", 3},
-            {"arccos", 3},
-            {"arctg",  3},
-            {"arctan", 3},
-            {"arcctg", 3},
-            {"asin",   3},
-            {"acos",   3},
-            {"atg",    3},
-            {"atan",   3},
-            {"actg",   3},
-            {"abs",    3},
-            {"int",    3},
-            {"sqrt",   3}
+     * Snapshot - класс неизменяемого снимка реестра: словари операций и функций и плоская таблица имен
+     * Разбор выражения берет снимок один раз и работает только с ним. Добавление операции строит новый снимок
+     * из копии текущего и публикует его атомарно, старый снимок живет, пока на него есть ссылки
+     * Снимок может лежать поверх базового снимка: тогда в нем хранятся только собственные операции,
+     * а остальные имена ищутся в базовом, который общий для всех таких снимков и не копируется
+     */
+    class Snapshot {
+    private:
+
+        /**
+         * Дружественный класс Operations
+         * Только Operations строит снимки, после публикации снимок не изменяется
+         */
+        friend class Operations;
+
+        /**
+         * Поле класса Snapshot
+         * binaryOperations - хранит словарь бинарных операций:
+         *  Ключ - имя операции типа string
+         *  Значение - описание операции
+         * Очередность операций: слева направо
+         * Снимок не изменяется, поэтому токены, разобранные по снимку, могут хранить указатели на описания
+         */
+        map<string, BinaryOperation> binaryOperations = {
+                {"+", {[](const Fraction &a, const Fraction &b) { return a + b; }, additivePriority}},
+                {"-", {[](const Fraction &a, const Fraction &b) { return a - b; }, additivePriority}},
+                {"*", {[](const Fraction &a, const Fraction &b) { return a * b; }, multiplicativePriority}},
+                {"/", {[](const Fraction &a, const Fraction &b) { return a / b; }, multiplicativePriority}},
+                {"^", {[](const Fraction &a, const Fraction &b) { return Fraction::Power(a, b); }, powerPriority}},
+                {"e", {[](const Fraction &a, const Fraction &b) {
+                    return a * Fraction::Power(Fraction(10.0), b);
+                }, powerPriority}}
+        };
+
+        /**
+         * Поле класса Snapshot
+         * unaryOperations - хранит словарь унарных операций:
+         *  Ключ - имя операции типа string
+         *  Значение - описание операции
+         * Очередность операций: слева направо
+         */
+        map<string, UnaryOperation> unaryOperations = {
+                {"+", {[](const Fraction &a) { return a; }, additivePriority}},
+                {"-", {[](const Fraction &a) { return -a; }, additivePriority}}
+        };
+
+        /**
+         * Поле класса Snapshot
+         * functions - хранит словарь функций:
+         *  Ключ - имя функции типа string
+         *  Значение - описание функции
+         * Очередность функций: слева направо
+         */
+        map<string, Function> functions{
+                {"sin",    {[](const vector<Fraction> &a) { return Fraction(sin((long double) a[0])); }, 3, 1}},
+                {"cos",    {[](const vector<Fraction> &a) { return Fraction(cos((long double) a[0])); }, 3, 1}},
+                {"tg",     {[](const vector<Fraction> &a) { return Fraction(tan((long double) a[0])); }, 3, 1}},
+                {"tan",    {[](const vector<Fraction> &a) { return Fraction(tan((long double) a[0])); }, 3, 1}},
+                {"ctg",    {[](const vector<Fraction> &a) {
+                    return Fraction(cos((long double) a[0]) / sin((long double) a[0]));
+                }, 3, 1}},
+                {"arcsin", {[](const vector<Fraction> &a) { return Fraction(asin((long double) a[0])); }, 3, 1}},
+                {"arccos", {[](const vector<Fraction> &a) { return Fraction(acos((long double) a[0])); }, 3, 1}},
+                {"arctg",  {[](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }, 3, 1}},
+                {"arctan", {[](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }, 3, 1}},
+                {"arcctg", {[](const vector<Fraction> &a) {
+                    return Fraction(M_PI_2 - atan((long double) a[0]));
+                }, 3, 1}},
+                {"asin",   {[](const vector<Fraction> &a) { return Fraction(asin((long double) a[0])); }, 3, 1}},
+                {"acos",   {[](const vector<Fraction> &a) { return Fraction(acos((long double) a[0])); }, 3, 1}},
+                {"atg",    {[](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }, 3, 1}},
+                {"atan",   {[](const vector<Fraction> &a) { return Fraction(atan((long double) a[0])); }, 3, 1}},
+                {"actg",   {[](const vector<Fraction> &a) {
+                    return Fraction(M_PI_2 - atan((long double) a[0]));
+                }, 3, 1}},
+                {"abs",    {[](const vector<Fraction> &a) { return Fraction(abs((long double) a[0])); }, 3, 1}},
+                {"int",    {[](const vector<Fraction> &a) { return Fraction(floor((long double) a[0])); }, 3, 1}},
+                {"sqrt",   {[](const vector<Fraction> &a) { return Fraction::Power(a[0], Fraction(0.5)); }, 3, 1}}
+        };
+
+        /**
+         * Поле класса Snapshot
+         * registry - хранит плоскую хеш-таблицу с открытой адресацией от имени к записи Descriptor
+         * Размер таблицы - степень двойки, занято не больше половины ячеек, коллизии разрешаются линейным пробированием
+         * Описания хранятся в словарях выше, таблица лишь ссылается на них
+         */
+        vector<Descriptor> registry;
+
+        /**
+         * Поле класса Snapshot
+         * numberOfNames - хранит количество занятых ячеек registry
+         */
+        size_t numberOfNames = 0;
+
+        /**
+         * Поле класса Snapshot
+         * version - хранит номер снимка, каждое добавление операции увеличивает его на единицу
+         */
+        size_t version = 0;
+
+        /**
+         * Поле класса Snapshot
+         * base - хранит базовый снимок, nullptr - если снимок самостоятельный
+         */
+        shared_ptr<const Snapshot> base;
+
+        /**
+         * Закрытая функция-член класса Snapshot
+         * Register - возвращает запись реестра с именем name, при необходимости добавляет ее
+         * Новая запись получает описания одноименных операций базового снимка, чтобы не скрыть их
+         */
+        Descriptor &Register(const string &name);
+
+        /**
+         * Закрытая функция-член класса Snapshot
+         * Rebuild - заполняет registry по словарям снимка
+         */
+        void Rebuild();
+
+    public:
+
+        /**
+         * Конструктор по умолчанию класса Snapshot
+         * Создает снимок со встроенными операциями и функциями и назначает им ядра пакетного вычисления
+         */
+        Snapshot();
+
+        /**
+         * Конструктор класса Snapshot
+         * Создает пустой снимок поверх снимка base
+         */
+        explicit Snapshot(shared_ptr<const Snapshot> base);
+
+        /**
+         * Копирующий конструктор класса Snapshot
+         * Копирует словари и строит таблицу имен заново, чтобы она ссылалась на описания копии
+         */
+        Snapshot(const Snapshot &other);
+
+        /**
+         * Присваивание класса Snapshot запрещено
+         */
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        /**
+         * Функция-член класса Snapshot
+         * Find - возвращает запись реестра по имени за одно пробирование таблицы, nullptr - если имени нет
+         * Имена, которых нет в снимке, ищутся в базовом снимке
+         */
+        const Descriptor *Find(string_view name) const;
+
+        /**
+         * Функция-член класса Snapshot
+         * GetVersion - возвращает номер снимка
+         */
+        size_t GetVersion() const;
     };
 
+    /**
+     * Поле класса Operations
+     * snapshot - хранит текущий снимок реестра
+     * Читатели загружают его без блокировок записи, писатели подменяют его целиком
+     */
+    atomic<shared_ptr<const Snapshot>> snapshot;
+
+    /**
+     * Поле класса Operations
+     * writeLock - упорядочивает писателей, чтобы одновременные добавления не потеряли друг друга
+     */
+    mutex writeLock;
+
     /**
      * Закрытый конструктор по умолчанию класса Operations
      */
-    Operations() {};
+    Operations();
+
+    /**
+     * Закрытый конструктор класса Operations
+     * Создает реестр, первый снимок которого пуст и лежит поверх снимка base
+     */
+    explicit Operations(shared_ptr<const Snapshot> base);
+
+    /**
+     * Закрытая статическая функция-член класса Operations
+     * Hash - возвращает хеш FNV-1a имени
+     */
+    static size_t Hash(string_view name);
 
     /**
      * Закрытый копирующий конструктор класса Operations
@@ -158,32 +292,52 @@ private:
 
 public:
 
+    /**
+     * Поля класса Operations
+     * additivePriority, multiplicativePriority, powerPriority - приоритеты встроенных операций
+     * Используются словарями операций и разбором выражений при компиляции программы (StaticExpression)
+     */
+    static constexpr int additivePriority = 1;
+    static constexpr int multiplicativePriority = 2;
+    static constexpr int powerPriority = 3;
+
     /**
      * Статическая функция-член класса Operations
      * GetInstance - возвращает один единственный доступный экземпляр класс Operations
      */
     static Operations &GetInstance();
 
+    /**
+     * Функция-член класса Operations
+     * GetSnapshot - возвращает текущий снимок реестра, он не изменится, пока на него есть ссылка
+     */
+    shared_ptr<const Snapshot> GetSnapshot() const;
+
     /**
      * Функция-член класса Operations
      * AddBinaryOperation - добавляет бинарную операцию
+     * isPure - операция чистая (результат зависит только от аргументов), ее можно вычислять при компиляции
      */
     void AddBinaryOperation(const string &name,
-                            const function<Fraction(const Fraction &, const Fraction &)> &func, int priority = 3);
+                            const function<Fraction(const Fraction &, const Fraction &)> &func, int priority = 3,
+                            bool isPure = false);
 
     /**
      * Функция-член класса Operations
      * AddUnaryOperation - добавляет унарную операцию
+     * isPure - операция чистая (результат зависит только от аргумента), ее можно вычислять при компиляции
      */
-    void AddUnaryOperation(const string &name, const function<Fraction(const Fraction &)> &func, int priority = 3);
+    void AddUnaryOperation(const string &name, const function<Fraction(const Fraction &)> &func, int priority = 3,
+                           bool isPure = false);
 
     /**
      * Функция-член класса Operations
      * AddFunction - добавляет функцию
      * numberOfArguments - количество аргументов, которое принимает функция, если равно 0, то неограниченное количество
+     * isPure - функция чистая (результат зависит только от аргументов), ее можно вычислять при компиляции
      */
     void AddFunction(const string &name, const function<Fraction(const vector<Fraction> &)> &func, int priority = 3,
-                     int numberOfArguments = 0);
+                     int numberOfArguments = 0, bool isPure = false);
 
     /**
      * Функция-член класса Operations
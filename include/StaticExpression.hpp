@@ -0,0 +1,550 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "Fraction.hpp"
+#include "Operations.hpp"
+#include "BatchKernels.hpp"
+
+using namespace std;
+
+/**
+ * Класс строки фиксированной длины
+ * Позволяет передать строковый литерал параметром шаблона StaticExpression
+ */
+template<size_t N>
+struct FixedString {
+
+    /**
+     * Поле структуры FixedString
+     * value - хранит символы литерала вместе с завершающим нулем
+     */
+    char value[N];
+
+    /**
+     * Конструктор структуры FixedString
+     */
+    consteval FixedString(const char (&str)[N]) {
+        for (size_t i = 0; i < N; i++) value[i] = str[i];
+    }
+
+    /**
+     * Функция-член структуры FixedString
+     * GetView - возвращает литерал без завершающего нуля
+     */
+    consteval string_view GetView() const { return string_view(value, N - 1); }
+};
+
+/**
+ * Класс программы, разобранной при компиляции
+ * Хранит дерево выражения в массиве узлов, корень - последний узел
+ * Разбор повторяет грамматику и приоритеты MathExpression, но знает только встроенные операции и функции:
+ * пользовательские операции появляются в Operations лишь во время работы программы
+ */
+class StaticProgram {
+public:
+
+    /**
+     * Поля класса StaticProgram
+     * maxNumberOfTokens, maxNumberOfVariables, maxLengthOfName - ограничения размера выражения
+     */
+    static const size_t maxNumberOfTokens = 256;
+    static const size_t maxNumberOfVariables = 16;
+    static const size_t maxLengthOfName = 31;
+
+    /**
+     * Поле класса StaticProgram
+     * TypeOfNodes - перечисление типов узлов
+     */
+    enum TypeOfNodes {
+        constant, variable, unaryOperation, binaryOperation, func
+    };
+
+    /**
+     * Поле класса StaticProgram
+     * Node - структура узла дерева
+     *  operation - символ операции для unaryOperation и binaryOperation
+     *  kernel - функция для func, в StaticExpression вычисляется так же, как одноименная функция Operations
+     *  numerator, denominator - значение константы
+     *  index - номер переменной
+     *  left, right - номера узлов-аргументов
+     */
+    struct Node {
+        TypeOfNodes type = constant;
+        char operation = 0;
+        BatchKernels::TypeOfKernels kernel = BatchKernels::generic;
+        long long numerator = 0;
+        long long denominator = 1;
+        size_t index = 0;
+        size_t left = 0;
+        size_t right = 0;
+    };
+
+    /**
+     * Поля класса StaticProgram
+     * nodes, numberOfNodes - хранят узлы дерева
+     */
+    Node nodes[maxNumberOfTokens] = {};
+    size_t numberOfNodes = 0;
+
+    /**
+     * Поля класса StaticProgram
+     * variables, numberOfVariables - хранят имена переменных в порядке первого появления в выражении
+     */
+    char variables[maxNumberOfVariables][maxLengthOfName + 1] = {};
+    size_t numberOfVariables = 0;
+
+    /**
+     * Статическая функция-член класса StaticProgram
+     * Parse - разбирает выражение при компиляции, ошибка в выражении является ошибкой компиляции
+     */
+    static consteval StaticProgram Parse(string_view expression);
+
+private:
+
+    /**
+     * Поле класса StaticProgram
+     * TypeOfTokens - перечисление типов токенов, совпадает с MathExpression
+     */
+    enum TypeOfTokens {
+        unknown, number, variableName, comma, openBracket, closeBracket, binary, unary, function
+    };
+
+    /**
+     * Поле класса StaticProgram
+     * Token - структура токена, хранит положение токена в строке и найденные при разборе свойства
+     */
+    struct Token {
+        TypeOfTokens type = unknown;
+        size_t offset = 0;
+        size_t length = 0;
+        int priority = 0;
+        char operation = 0;
+        BatchKernels::TypeOfKernels kernel = BatchKernels::generic;
+        size_t numberOfArguments = 0;
+    };
+
+    /**
+     * Закрытая статическая функция-член класса StaticProgram
+     * Fail - сообщает об ошибке разбора
+     * Функция не constexpr, поэтому ее вызов при компиляции прерывает компиляцию и выводит сообщение
+     */
+    static void Fail(const char *message) { throw runtime_error(message); }
+
+    /**
+     * Закрытые статические функции-члены класса StaticProgram
+     * IsDigit, IsLetter, IsSpace, ToLower - классы символов ASCII, не зависящие от локали
+     */
+    static constexpr bool IsDigit(char symbol) { return symbol >= '0' && symbol <= '9'; }
+
+    static constexpr bool IsLetter(char symbol) {
+        return (symbol >= 'a' && symbol <= 'z') || (symbol >= 'A' && symbol <= 'Z');
+    }
+
+    static constexpr bool IsSpace(char symbol) {
+        return symbol == ' ' || symbol == '\t' || symbol == '\n' || symbol == '\v' || symbol == '\f' || symbol == '\r';
+    }
+
+    static constexpr char ToLower(char symbol) {
+        return (symbol >= 'A' && symbol <= 'Z' ? (char) (symbol - 'A' + 'a') : symbol);
+    }
+
+    /**
+     * Закрытая статическая функция-член класса StaticProgram
+     * IsName - сравнивает слово выражения с именем без учета регистра
+     */
+    static constexpr bool IsName(string_view word, string_view name) {
+        if (word.size() != name.size()) return false;
+
+        for (size_t i = 0; i < word.size(); i++)
+            if (ToLower(word[i]) != name[i]) return false;
+
+        return true;
+    }
+
+    /**
+     * Закрытая статическая функция-член класса StaticProgram
+     * FindFunctionKernel - возвращает встроенную функцию по имени, generic - если такой нет
+     */
+    static constexpr BatchKernels::TypeOfKernels FindFunctionKernel(string_view word) {
+        for (const auto &[name, kernel]: BatchKernels::functionKernels)
+            if (IsName(word, name)) return kernel;
+
+        return BatchKernels::generic;
+    }
+
+    /**
+     * Закрытая статическая функция-член класса StaticProgram
+     * ParseNumber - переводит число в дробь по тем же правилам, что и Fraction::ScanDecimal и Fraction::FromDecimal
+     */
+    static consteval Node ParseNumber(string_view number);
+
+    /**
+     * Закрытая статическая функция-член класса StaticProgram
+     * AddNode - добавляет узел и возвращает его номер
+     */
+    consteval size_t AddNode(const Node &node);
+
+    /**
+     * Закрытая функция-член класса StaticProgram
+     * FindVariable - возвращает номер переменной, при необходимости добавляет ее
+     */
+    consteval size_t FindVariable(string_view name);
+};
+
+consteval StaticProgram::Node StaticProgram::ParseNumber(string_view number) {
+    // Наибольший порядок, при котором знаменатель 10^-exponent помещается в long long
+    const long long maxNumberOfDecimals = 18;
+
+    Fraction::Decimal decimal = Fraction::ScanDecimal(number);
+    Node node;
+    auto numerator = (long long) decimal.mantissa;
+    long long denominator = 1;
+
+    if (!decimal.isValid || decimal.length != number.size()) Fail("Ошибка. Некорректное число");
+
+    if (numerator != 0) {
+        for (long long i = 0; i < decimal.exponent; i++)
+            if (__builtin_mul_overflow(numerator, 10LL, &numerator)) Fail("Ошибка. Слишком большое число");
+        // Fraction округлила бы такое число, а при компиляции long double недоступен
+        if (decimal.exponent < -maxNumberOfDecimals) Fail("Ошибка. Слишком много знаков после точки");
+        for (long long i = 0; i < -decimal.exponent; i++) denominator *= 10;
+    }
+
+    long long a = numerator, b = denominator;
+    while (b) {
+        a %= b;
+        swap(a, b);
+    }
+
+    node.numerator = numerator / a;
+    node.denominator = denominator / a;
+
+    return node;
+}
+
+consteval size_t StaticProgram::AddNode(const Node &node) {
+    if (numberOfNodes == maxNumberOfTokens) Fail("Ошибка. Слишком длинное выражение");
+
+    nodes[numberOfNodes] = node;
+    return numberOfNodes++;
+}
+
+consteval size_t StaticProgram::FindVariable(string_view name) {
+    for (size_t i = 0; i < numberOfVariables; i++)
+        if (IsName(name, variables[i])) return i;
+
+    if (numberOfVariables == maxNumberOfVariables) Fail("Ошибка. Слишком много переменных");
+    if (name.size() > maxLengthOfName) Fail("Ошибка. Слишком длинное имя переменной");
+
+    for (size_t i = 0; i < name.size(); i++) variables[numberOfVariables][i] = ToLower(name[i]);
+    return numberOfVariables++;
+}
+
+consteval StaticProgram StaticProgram::Parse(string_view expression) {
+    StaticProgram program;
+    Token postfix[maxNumberOfTokens] = {};
+    Token tokens[maxNumberOfTokens] = {};
+    size_t sizeOfPostfix = 0, sizeOfTokens = 0;
+    size_t index = 0, numberOfOpenBrackets = 0;
+    TypeOfTokens previousTokenType = unknown;
+
+    if (expression.empty()) Fail("Ошибка. Пустое выражение");
+
+    // Разбор на токены и построение обратной польской нотации, как в MathExpression::BuildPostfixNotation
+    while (true) {
+        while (index < expression.size() && IsSpace(expression[index])) index++;
+        if (index == expression.size()) break;
+
+        Token token;
+        token.offset = index;
+
+        if (IsDigit(expression[index]) || expression[index] == '.') {
+            index += Fraction::ScanDecimal(expression.substr(index)).length;
+            token.type = number;
+        } else if (IsLetter(expression[index])) {
+            while (index < expression.size() && IsLetter(expression[index])) index++;
+
+            string_view word = expression.substr(token.offset, index - token.offset);
+            token.kernel = FindFunctionKernel(word);
+
+            if (token.kernel != BatchKernels::generic) {
+                size_t position = index;
+                while (position < expression.size() && IsSpace(expression[position])) position++;
+                if (position == expression.size() || expression[position] != '(')
+                    Fail("Ошибка. После функции ожидается '('");
+
+                token.type = function;
+            } else if (IsName(word, "e")) {
+                token.type = binary;
+                token.operation = 'e';
+                token.priority = Operations::powerPriority;
+            } else {
+                // Имя переменной может содержать цифры и '_'
+                while (index < expression.size() &&
+                       (IsLetter(expression[index]) || IsDigit(expression[index]) || expression[index] == '_'))
+                    index++;
+                token.type = variableName;
+            }
+        } else {
+            token.operation = expression[index++];
+
+            switch (token.operation) {
+                case ',':
+                    token.type = comma;
+                    break;
+                case '(':
+                    token.type = openBracket;
+                    numberOfOpenBrackets++;
+                    break;
+                case ')':
+                    if (numberOfOpenBrackets == 0) Fail("Ошибка. Некорректная скобочная последовательность");
+                    token.type = closeBracket;
+                    numberOfOpenBrackets--;
+                    break;
+                case '+':
+                case '-':
+                    // Операция бинарная, если перед ней стоит операнд: число, переменная или закрывающая скобка
+                    token.type = ((previousTokenType == number || previousTokenType == variableName ||
+                                   previousTokenType == closeBracket) ? binary : unary);
+                    token.priority = Operations::additivePriority;
+                    break;
+                case '*':
+                case '/':
+                    token.type = binary;
+                    token.priority = Operations::multiplicativePriority;
+                    break;
+                case '^':
+                    token.type = binary;
+                    token.priority = Operations::powerPriority;
+                    break;
+                default:
+                    Fail("Ошибка. Такой операции нет");
+            }
+        }
+
+        token.length = index - token.offset;
+        previousTokenType = token.type;
+
+        if (sizeOfPostfix == maxNumberOfTokens || sizeOfTokens == maxNumberOfTokens)
+            Fail("Ошибка. Слишком длинное выражение");
+
+        switch (token.type) {
+            case comma:
+                while (sizeOfTokens != 0 && tokens[sizeOfTokens - 1].type != openBracket)
+                    postfix[sizeOfPostfix++] = tokens[--sizeOfTokens];
+                if (sizeOfTokens != 0) tokens[sizeOfTokens - 1].numberOfArguments++;
+                postfix[sizeOfPostfix++] = token;
+                break;
+
+            case number:
+            case variableName:
+                postfix[sizeOfPostfix++] = token;
+                break;
+
+            case closeBracket: {
+                while (tokens[sizeOfTokens - 1].type != openBracket) postfix[sizeOfPostfix++] = tokens[--sizeOfTokens];
+                size_t numberOfCommas = tokens[--sizeOfTokens].numberOfArguments;
+
+                if (sizeOfTokens != 0 && tokens[sizeOfTokens - 1].type == function) {
+                    postfix[sizeOfPostfix] = tokens[--sizeOfTokens];
+                    postfix[sizeOfPostfix++].numberOfArguments = numberOfCommas + 1;
+                }
+                break;
+            }
+
+            case binary:
+                while (sizeOfTokens != 0 &&
+                       (tokens[sizeOfTokens - 1].type == binary || tokens[sizeOfTokens - 1].type == unary) &&
+                       token.priority <= tokens[sizeOfTokens - 1].priority)
+                    postfix[sizeOfPostfix++] = tokens[--sizeOfTokens];
+                tokens[sizeOfTokens++] = token;
+                break;
+
+            default:
+                tokens[sizeOfTokens++] = token;
+                break;
+        }
+    }
+
+    if (numberOfOpenBrackets != 0) Fail("Ошибка. Некорректная скобочная последовательность");
+
+    while (sizeOfTokens != 0) postfix[sizeOfPostfix++] = tokens[--sizeOfTokens];
+
+    // Построение дерева с теми же проверками операндов, что и в MathExpression::Compile
+    size_t stack[maxNumberOfTokens] = {};
+    size_t depth = 0;
+
+    for (size_t i = 0; i < sizeOfPostfix; i++) {
+        const Token &token = postfix[i];
+        Node node;
+
+        switch (token.type) {
+            case comma:
+                if (depth == 0) Fail("Ошибка. Ожидается операнд");
+                continue;
+
+            case number:
+                node = ParseNumber(expression.substr(token.offset, token.length));
+                break;
+
+            case variableName:
+                node.type = variable;
+                node.index = program.FindVariable(expression.substr(token.offset, token.length));
+                break;
+
+            case unary:
+                if (depth < 1) Fail("Ошибка вычисления. Пропущен операнд");
+                node.type = unaryOperation;
+                node.operation = token.operation;
+                node.left = stack[--depth];
+                break;
+
+            case binary:
+                if (depth < 2) Fail("Ошибка вычисления. Пропущен операнд");
+                node.type = binaryOperation;
+                node.operation = token.operation;
+                node.right = stack[--depth];
+                node.left = stack[--depth];
+                break;
+
+            case function:
+                if (depth < token.numberOfArguments) Fail("Ошибка. Пропущен аргумент функции");
+                if (token.numberOfArguments != 1) Fail("Ошибка вычисления. Встроенные функции принимают один аргумент");
+                node.type = func;
+                node.kernel = token.kernel;
+                node.left = stack[--depth];
+                break;
+
+            default:
+                continue;
+        }
+
+        stack[depth++] = program.AddNode(node);
+    }
+
+    if (depth > 1) Fail("Ошибка вычисления. Пропущен оператор или функция");
+
+    if (depth == 0) Fail("Ошибка вычисления. Лишний оператор или функция");
+
+    return program;
+}
+
+/**
+ * Класс выражения, разобранного при компиляции
+ * text - строковый литерал выражения, ошибка в нем является ошибкой компиляции
+ * Каждый узел дерева превращается в прямой вызов операции Fraction, без std::function и байт-кода,
+ * поэтому компилятор может встроить все вычисление в место вызова
+ * Пример: StaticExpression<"x * 2 + sin(y)"> f; f(Fraction(1.0), Fraction(0.5));
+ */
+template<FixedString text>
+class StaticExpression {
+private:
+
+    /**
+     * Поле класса StaticExpression
+     * program - хранит программу, разобранную при компиляции
+     */
+    static constexpr StaticProgram program = StaticProgram::Parse(text.GetView());
+
+    // Разбор выполняется уже при объявлении объекта, а не при первом вызове
+    static_assert(program.numberOfNodes != 0);
+
+    /**
+     * Закрытая статическая функция-член класса StaticExpression
+     * EvalNode - вычисляет поддерево с корнем в узле node
+     */
+    template<size_t node>
+    static Fraction EvalNode(const Fraction *values) {
+        constexpr StaticProgram::Node current = program.nodes[node];
+
+        if constexpr (current.type == StaticProgram::constant) {
+            Fraction result;
+            result.SetNumerator(current.numerator);
+            result.SetDenominator(current.denominator);
+            return result;
+        } else if constexpr (current.type == StaticProgram::variable) {
+            return values[current.index];
+        } else if constexpr (current.type == StaticProgram::unaryOperation) {
+            if constexpr (current.operation == '-') return -EvalNode<current.left>(values);
+            else return EvalNode<current.left>(values);
+        } else if constexpr (current.type == StaticProgram::binaryOperation) {
+            Fraction a = EvalNode<current.left>(values);
+            Fraction b = EvalNode<current.right>(values);
+
+            if constexpr (current.operation == '+') return a + b;
+            else if constexpr (current.operation == '-') return a - b;
+            else if constexpr (current.operation == '*') return a * b;
+            else if constexpr (current.operation == '/') return a / b;
+            else if constexpr (current.operation == '^') return Fraction::Power(a, b);
+            else return a * Fraction::Power(Fraction(10.0), b);
+        } else {
+            // Функции вычисляются так же, как одноименные функции в Operations
+            Fraction a = EvalNode<current.left>(values);
+
+            if constexpr (current.kernel == BatchKernels::sine) return Fraction(sin((long double) a));
+            else if constexpr (current.kernel == BatchKernels::cosine) return Fraction(cos((long double) a));
+            else if constexpr (current.kernel == BatchKernels::tangent) return Fraction(tan((long double) a));
+            else if constexpr (current.kernel == BatchKernels::cotangent)
+                return Fraction(cos((long double) a) / sin((long double) a));
+            else if constexpr (current.kernel == BatchKernels::arcsine) return Fraction(asin((long double) a));
+            else if constexpr (current.kernel == BatchKernels::arccosine) return Fraction(acos((long double) a));
+            else if constexpr (current.kernel == BatchKernels::arctangent) return Fraction(atan((long double) a));
+            else if constexpr (current.kernel == BatchKernels::arccotangent)
+                return Fraction(M_PI_2 - atan((long double) a));
+            else if constexpr (current.kernel == BatchKernels::absolute) return Fraction(abs((long double) a));
+            else if constexpr (current.kernel == BatchKernels::integral) return Fraction(floor((long double) a));
+            else return Fraction::Power(a, Fraction(0.5));
+        }
+    }
+
+public:
+
+    /**
+     * Поле класса StaticExpression
+     * numberOfVariables - количество переменных выражения
+     */
+    static constexpr size_t numberOfVariables = program.numberOfVariables;
+
+    /**
+     * Функция-член класса StaticExpression
+     * operator() - вычисляет выражение, значения передаются в порядке первого появления переменных в выражении
+     */
+    template<class... Values>
+    requires (is_same_v<Values, Fraction> && ...)
+    Fraction operator()(const Values &... values) const {
+        static_assert(sizeof...(Values) == numberOfVariables, "Количество значений не совпадает с количеством переменных");
+
+        const array<Fraction, sizeof...(Values)> arguments{values...};
+        return EvalNode<program.numberOfNodes - 1>(arguments.data());
+    }
+
+    /**
+     * Функция-член класса StaticExpression
+     * Eval - вычисляет выражение, values[i] соответствует переменной GetVariables()[i]
+     */
+    Fraction Eval(span<const Fraction> values = {}) const {
+        if (values.size() < numberOfVariables)
+            throw runtime_error("Ошибка. Не задано значение переменной " + string(program.variables[values.size()]));
+
+        return EvalNode<program.numberOfNodes - 1>(values.data());
+    }
+
+    /**
+     * Функция-член класса StaticExpression
+     * GetVariables - возвращает имена переменных в порядке их номеров
+     */
+    vector<string> GetVariables() const {
+        vector<string> variables;
+        for (size_t i = 0; i < numberOfVariables; i++) variables.emplace_back(program.variables[i]);
+        return variables;
+    }
+};
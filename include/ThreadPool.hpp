@@ -0,0 +1,143 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * Класс пула потоков с перехватом работы
+ * У каждого потока своя очередь диапазонов: поток берет работу с конца своей очереди, а простаивающий поток
+ * забирает ее с начала чужой. Диапазон делится пополам только тогда, когда своя очередь пуста, а размер порции,
+ * выполняемой за раз, подстраивается под стоимость одного элемента
+ */
+class ThreadPool {
+private:
+
+    /**
+     * Поле класса ThreadPool
+     * Range - структура диапазона элементов [begin, end)
+     */
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    /**
+     * Поле класса ThreadPool
+     * Queue - структура очереди диапазонов одного потока
+     */
+    struct Queue {
+        mutex lock;
+        deque<Range> ranges;
+    };
+
+    /**
+     * Поле класса ThreadPool
+     * queues - хранит очереди потоков, последняя очередь принадлежит потоку, вызвавшему ParallelFor
+     */
+    vector<unique_ptr<Queue>> queues;
+
+    /**
+     * Поле класса ThreadPool
+     * threads - хранит рабочие потоки
+     */
+    vector<thread> threads;
+
+    /**
+     * Поля класса ThreadPool
+     * lock, wakeUp - пробуждают рабочие потоки при появлении новой задачи
+     * generation - номер текущей задачи, isStopped - пул уничтожается
+     */
+    mutex lock;
+    condition_variable wakeUp;
+    size_t generation = 0;
+    bool isStopped = false;
+
+    /**
+     * Поле класса ThreadPool
+     * parallelForLock - пул выполняет одну задачу ParallelFor за раз
+     */
+    mutex parallelForLock;
+
+    /**
+     * Поля класса ThreadPool
+     * body - тело текущей задачи, remaining - количество еще не выполненных элементов
+     */
+    const function<void(size_t, size_t)> *body = nullptr;
+    atomic<size_t> remaining = 0;
+
+    /**
+     * Поля класса ThreadPool
+     * error - первое исключение тела задачи, isFailed - после исключения оставшиеся элементы пропускаются
+     */
+    mutex errorLock;
+    exception_ptr error;
+    atomic<bool> isFailed = false;
+
+    /**
+     * Закрытая функция-член класса ThreadPool
+     * Work - цикл рабочего потока с номером index
+     */
+    void Work(size_t index);
+
+    /**
+     * Закрытая функция-член класса ThreadPool
+     * Run - выполняет диапазоны текущей задачи, пока она не закончится
+     */
+    void Run(size_t index);
+
+    /**
+     * Закрытая функция-член класса ThreadPool
+     * Pop - берет диапазон из своей очереди или крадет из чужой, возвращает false, если работы нет
+     */
+    bool Pop(size_t index, Range &range);
+
+    /**
+     * Закрытая функция-член класса ThreadPool
+     * Execute - выполняет диапазон порциями, отдавая половину остатка в свою очередь, если она пуста
+     */
+    void Execute(size_t index, Range range);
+
+public:
+
+    /**
+     * Конструктор класса ThreadPool
+     * numberOfThreads - общее количество потоков вместе с потоком, вызывающим ParallelFor
+     */
+    explicit ThreadPool(size_t numberOfThreads = thread::hardware_concurrency());
+
+    /**
+     * Деструктор класса ThreadPool
+     * Останавливает и дожидается рабочих потоков
+     */
+    ~ThreadPool();
+
+    /**
+     * Копирующий конструктор и присваивание класса ThreadPool запрещены
+     */
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Функция-член класса ThreadPool
+     * GetNumberOfThreads - возвращает общее количество потоков
+     */
+    size_t GetNumberOfThreads() const;
+
+    /**
+     * Функция-член класса ThreadPool
+     * ParallelFor - вызывает body(begin, end) для непересекающихся диапазонов, покрывающих [0, size),
+     * и возвращает управление, когда все они выполнены. Вызывающий поток тоже выполняет работу
+     * Первое исключение из body передается вызывающему
+     */
+    void ParallelFor(size_t size, const function<void(size_t begin, size_t end)> &body);
+};
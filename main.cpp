@@ -1,10 +1,32 @@
 #include <iostream>
+#include <filesystem>
 #include "include/MathParser.hpp"
+#include "include/ExpressionCache.hpp"
+#include "include/StaticExpression.hpp"
+#include "include/JitExpression.hpp"
+#include "include/NativeModule.hpp"
+#include "include/ThreadPool.hpp"
+#include "include/EvaluationContext.hpp"
 
 using namespace std;
 
 int errors = 0;
 
+// Счетчик выделений памяти в куче, по нему testAllocations проверяет, что вычисление не выделяет память
+atomic<size_t> numberOfAllocations = 0;
+
+// Не встраиваются, иначе GCC видит malloc и free рядом с new и delete в местах вызова
+// и ошибочно предупреждает о несоответствии
+[[gnu::noinline]] void *operator new(size_t size) {
+    numberOfAllocations++;
+    if (void *pointer = malloc(size ? size : 1)) return pointer;
+    throw bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *pointer) noexcept { free(pointer); }
+
+[[gnu::noinline]] void operator delete(void *pointer, size_t) noexcept { free(pointer); }
+
 void test(const string &input, long double expected) {
     try {
         MathExpression expression(input);
@@ -16,6 +38,354 @@ void test(const string &input, long double expected) {
     }
 }
 
+void test(const string &input, const vector<Fraction> &values, long double expected) {
+    try {
+        CompiledExpression expression = MathExpression(input).Compile();
+        Fraction result = expression.Eval(values);
+        cout << input << " = " << expected << " : got " << (long double) result << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testBatch(const string &input, const vector<vector<double>> &columns, const vector<double> &expected) {
+    try {
+        CompiledExpression expression = MathExpression(input).Compile();
+        vector<const double *> pointers;
+        vector<double> result(expected.size());
+
+        for (const auto &column: columns) pointers.push_back(column.data());
+        expression.EvalBatch(pointers, result);
+
+        for (size_t i = 0; i < result.size(); i++)
+            cout << input << " [" << i << "] = " << expected[i] << " : got " << result[i] << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testJit(const string &input, const vector<vector<double>> &columns, const vector<double> &expected) {
+    try {
+        JitExpression expression(MathExpression(input).Compile());
+        vector<const double *> pointers;
+        vector<double> result(expected.size());
+
+        for (const auto &column: columns) pointers.push_back(column.data());
+        expression.EvalBatch(pointers, result);
+
+        for (size_t i = 0; i < result.size(); i++)
+            cout << input << " [jit " << expression.IsCompiled() << ", " << i << "] = " << expected[i] << " : got "
+                 << result[i] << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testNative(const vector<string> &inputs, const vector<double> &values, const vector<double> &expected) {
+    try {
+        NativeModule module(inputs);
+
+        for (size_t i = 0; i < inputs.size(); i++)
+            cout << inputs[i] << " [native] = " << expected[i] << " : got " << module.Eval(i, values) << endl;
+    } catch (exception &e) {
+        cout << "native : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testNativeShared(const string &input, const vector<double> &values, double expected) {
+    try {
+        // Модули с одинаковым кодом загружают одну библиотеку из кэша, но таблицы переходов у каждого свои
+        NativeModule first({input});
+        {
+            NativeModule second({input});
+            cout << input << " [native, shared " << (second.GetPath() == first.GetPath()) << "] = " << expected
+                 << " : got " << second.Eval(0, values) << endl;
+        }
+        cout << input << " [native, after unload] = " << expected << " : got " << first.Eval(0, values) << endl;
+    } catch (exception &e) {
+        cout << "native : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testNativeCache(const string &input, const vector<double> &values, double expected) {
+    // Компилятор запускается без оболочки, поэтому кавычка и пробел в пути каталога не мешают сборке
+    string directory = (filesystem::temp_directory_path() /
+                        ("mathparser it's " + to_string(chrono::steady_clock::now().time_since_epoch().count())))
+            .string();
+
+    try {
+        NativeModule module({input}, directory);
+        cout << input << " [native, private cache " << module.IsLoadedFromCache() << "] = " << expected
+             << " : got " << module.Eval(0, values) << endl;
+    } catch (exception &e) {
+        cout << "native : exception: " << e.what() << endl;
+        ++errors;
+    }
+
+    // Из каталога, открытого для записи другим пользователям, модуль не загружается
+    try {
+        filesystem::permissions(directory, filesystem::perms::all);
+        NativeModule module({input}, directory);
+        cout << input << " [native, shared cache] = exception : got " << module.Eval(0, values) << endl;
+    } catch (exception &e) {
+        cout << input << " [native, shared cache] : exception: " << e.what() << endl;
+        ++errors;
+    }
+
+    error_code error;
+    filesystem::remove_all(directory, error);
+}
+
+void testParallel(const string &input, size_t numberOfRows) {
+    try {
+        CompiledExpression expression = MathExpression(input).Compile();
+        ThreadPool pool(4);
+        vector<double> x(numberOfRows), expected(numberOfRows), result(numberOfRows);
+        vector<const double *> pointers = {x.data()};
+        size_t mismatches = 0;
+
+        for (size_t i = 0; i < numberOfRows; i++) x[i] = (double) i / 7;
+        expression.EvalBatch(pointers, expected);
+        expression.EvalBatch(pointers, result, pool);
+
+        for (size_t i = 0; i < numberOfRows; i++) mismatches += (result[i] != expected[i]);
+        cout << input << " [parallel, " << numberOfRows << " rows] mismatches = 0 : got " << mismatches << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testSnapshot() {
+    // Выражение разбирается по снимку реестра, взятому при создании, и не видит функцию, добавленную позже
+    MathExpression before("twice(4) + 1");
+    Operations::GetInstance().AddFunction("twice", [](const vector<Fraction> &a) { return a[0] * Fraction(2.0); }, 3, 1);
+
+    test("twice(4) + 1", 9);
+
+    try {
+        Fraction result = before.Eval();
+        cout << "twice(4) + 1 [old snapshot] = exception : got " << (long double) result << endl;
+    } catch (exception &e) {
+        cout << "twice(4) + 1 [old snapshot] : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testCacheInvalidation() {
+    // Запись, скомпилированная до добавления функции, компилируется заново по новому снимку реестра
+    ExpressionCache cache(4, 1);
+    auto before = cache.Get("1 + 2");
+    Operations::GetInstance().AddFunction("renewed", [](const vector<Fraction> &a) { return a[0]; }, 3, 1);
+    auto after = cache.Get("1 + 2");
+
+    cout << "1 + 2 [cache after AddFunction] recompiled 1 : got " << (before != after) << ", misses 2 : got "
+         << cache.GetMisses() << endl;
+}
+
+void testConcurrentRegistration(const string &input, size_t numberOfTasks) {
+    try {
+        ThreadPool pool(4);
+        ExpressionCache cache(64, 4);
+        vector<Fraction> expected;
+        atomic<size_t> mismatches = 0;
+
+        for (int x = 0; x < 10; x++) expected.push_back(MathExpression(input).Compile().Eval({{Fraction(x * 1.0L)}}));
+
+        // Часть задач добавляет функции, пока остальные разбирают и вычисляют выражение напрямую и через кэш
+        pool.ParallelFor(numberOfTasks, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                if (i % 16 == 0) {
+                    string name = "added";
+                    for (size_t number = i; number != 0; number /= 26) name += (char) ('a' + number % 26);
+                    Operations::GetInstance().AddFunction(name, [](const vector<Fraction> &a) { return a[0] + a[0]; },
+                                                          3, 1);
+                    continue;
+                }
+
+                vector<Fraction> values = {Fraction((long double) (i % 10))};
+                mismatches += (MathExpression(input).Compile().Eval(values) != expected[i % 10]);
+                mismatches += (cache.Get(input)->Eval(values) != expected[i % 10]);
+            }
+        });
+
+        cout << input << " [" << numberOfTasks << " tasks with AddFunction] mismatches = 0 : got " << mismatches
+             << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testFolding() {
+    // Функции пользователя по умолчанию не чистые и вызываются при каждом Eval, чистые сворачиваются при компиляции
+    static int impureCalls = 0, pureCalls = 0;
+    Operations &operations = Operations::GetInstance();
+    operations.AddFunction("impure", [](const vector<Fraction> &a) { impureCalls++; return a[0]; }, 3, 1);
+    operations.AddFunction("pure", [](const vector<Fraction> &a) { pureCalls++; return a[0]; }, 3, 1, true);
+
+    CompiledExpression impure = MathExpression("impure(2) * x").Compile();
+    CompiledExpression pure = MathExpression("pure(2) * x").Compile();
+    vector<Fraction> values = {Fraction(1.0)};
+    int impureCallsBefore = impureCalls, pureCallsBefore = pureCalls;
+    for (int i = 0; i < 3; i++) {
+        impure.Eval(values);
+        pure.Eval(values);
+    }
+    cout << "impure(2) * x : calls in Eval 3 : got " << impureCalls - impureCallsBefore << endl;
+    cout << "pure(2) * x : calls in Eval 0 : got " << pureCalls - pureCallsBefore << endl;
+
+    // Ошибка в сворачиваемом подвыражении выбрасывается при вычислении, а не при компиляции
+    try {
+        CompiledExpression division = MathExpression("x + 1/(2 - 2)").Compile();
+        cout << "x + 1/(2 - 2) : compiled" << endl;
+        Fraction result = division.Eval(values);
+        cout << "x + 1/(2 - 2) = exception : got " << (long double) result << endl;
+    } catch (exception &e) {
+        cout << "x + 1/(2 - 2) : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testVariables(const string &input, const vector<string> &variables, const vector<Fraction> &values,
+                   long double expected) {
+    try {
+        CompiledExpression compiled = MathExpression(input).Compile(variables);
+        vector<Fraction> arguments(values.size());
+        // Значения раскладываются по индексам, найденным по именам в том виде, в каком их задал вызывающий
+        for (size_t i = 0; i < variables.size(); i++) arguments[compiled.GetVariableIndex(variables[i])] = values[i];
+        Fraction result = compiled.Eval(arguments);
+        cout << input << " [variables] = " << expected << " : got " << (long double) result << endl;
+    } catch (exception &e) {
+        cout << input << " [variables] : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testContext(const string &input, const EvaluationContext &context, long double expected) {
+    try {
+        Fraction result = MathExpression(input, context).Compile().Eval();
+        cout << input << " [context] = " << expected << " : got " << (long double) result << endl;
+    } catch (exception &e) {
+        cout << input << " [context] : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testAllocations(const string &input, const vector<Fraction> &values) {
+    try {
+        CompiledExpression expression = MathExpression(input).Compile();
+        EvaluationArena arena;
+
+        // Первые вычисления размечают рабочую память, дальше память в куче не выделяется
+        expression.Eval(values);
+        expression.Eval(values, arena);
+
+        size_t before = numberOfAllocations;
+        for (int i = 0; i < 1000; i++) {
+            expression.Eval(values);
+            expression.Eval(values, arena);
+        }
+
+        cout << input << " : allocations 0 : got " << numberOfAllocations - before << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+template<typename Number>
+void testNumeric(const string &input, const vector<Number> &values, long double expected) {
+    try {
+        Number result = MathExpression(input).Compile().EvalAs<Number>(values);
+        cout << input << " [" << (is_same_v<Number, double> ? "double" : "long double") << "] = " << expected
+             << " : got " << (long double) result << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testExact(const string &input, const string &expected) {
+    try {
+        cout << input << " = " << expected << " : got " << MathExpression(input).EvalExact().ToString() << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testDeduplication(const string &input, size_t expected) {
+    try {
+        CompiledExpression expression = MathExpression(input).Compile();
+        cout << input << " : deduplicated " << expected << " : got " << expression.GetNumberOfDeduplicatedNodes()
+             << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testInterval(const string &input, const vector<Interval> &box, long double lower, long double upper) {
+    try {
+        Interval result = MathExpression(input).Compile().EvalAs<Interval>(box);
+        cout << input << " [interval] = [" << lower << ", " << upper << "] : got [" << result.GetLower() << ", "
+             << result.GetUpper() << "]" << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testExtremum(const string &input, const vector<Interval> &box, long double minimum, long double maximum) {
+    try {
+        CompiledExpression expression = MathExpression(input).Compile();
+        CompiledExpression::Extremum lowest = expression.FindMinimum(box), highest = expression.FindMaximum(box);
+        cout << input << " : min " << minimum << ", max " << maximum << " : got min " << lowest.value.GetLower()
+             << ", max " << highest.value.GetUpper() << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testCache() {
+    ExpressionCache cache(2, 1);
+
+    for (const char *input: {"1 + 20", "1+20", " 1+ 20 ", "2 * 3", "4 - 1", "1+20"})
+        cout << input << " = " << (long double) cache.Get(input)->Eval() << endl;
+
+    cout << "Cache: hits " << cache.GetHits() << ", misses " << cache.GetMisses() << ", evictions "
+         << cache.GetEvictions() << endl;
+}
+
+void testStaticStorage(const string &input, const string &expected) {
+    // Кэш в статической памяти разрушается после пула длинных значений потока, как в MathParserBatch
+    static ExpressionCache cache(4, 1);
+
+    try {
+        cout << input << " [static storage] = " << expected << " : got " << cache.Get(input)->EvalExact().ToString()
+             << endl;
+    } catch (exception &e) {
+        cout << input << " : exception: " << e.what() << endl;
+        ++errors;
+    }
+}
+
+void testStatic() {
+    StaticExpression<"3 + 4 * 2 / ( 1 - 5 ) ^ 2 ^ 3"> first;
+    StaticExpression<"SIN(x)^2 + cos(x)^2 - 3.21E-2 * rate"> second;
+
+    cout << "static 3 + 4 * 2 / ( 1 - 5 ) ^ 2 ^ 3 = 3.00195 : got " << (long double) first() << endl;
+    cout << "static SIN(x)^2 + cos(x)^2 - 3.21E-2 * rate = 0.9679 : got "
+         << (long double) second(Fraction(0.5), Fraction(1.0)) << endl;
+}
+
 void tests() {
     test("0", 0);
     test("1", 1);
@@ -86,6 +456,8 @@ void tests() {
     test("4^(-4)", 0.00390625);
     test("(-8)^(-4)", 0.000244141);
     test("(-8)^(1/3)", -2);
+    test("(9/4)^(3/2) * 8 - (1/3)^20 * 3^20", 26);
+    test("(-2/3)^(-3) + (8/27)^(-2/3)", -1.125);
     test("sqrt(2)-1/2*sin(1^2-2)", 1.83495);
     test("1(e2)", 100);
     test("ctg(4)", 0.863691);
@@ -110,6 +482,10 @@ void tests() {
     test("min(-1+3432, -2+2, -131)", -131);
     test("0.8845875131313131", 0.8845875131313131);
     test("0.8845875131313131 * 0.284881", 0.252002);
+    test("(0.8845875131313131 * 0.284881 - 0.2520021753) * 10^10", 0.283616);
+    // 10^-21 не представим дробью из long long, и вместо молчаливого нуля вычисление сообщает об ошибке
+    // "Слишком маленькое число"; точное вычисление дает 1 (см. testExact ниже)
+    test("1/1000000000000 * 1/1000000000 * 10^21", 0);
     test("0.999999999 + 0.999999999", 1.999999998);
     test("min(1, 2, 3 - 5)", -2);
     test("min(1)", 1);
@@ -134,6 +510,69 @@ void tests() {
     test(" sin                                             ", 8);
     test(" 4    5                                            ", 9);
     test("sin(4,5)", 4);
+    test("x * 2 + rate", {Fraction(3.0), Fraction(0.5)}, 6.5);
+    test("t0 - x", {Fraction(10.0), Fraction(4.0)}, 6);
+    test("-x^2", {Fraction(3.0)}, -9);
+    test("sin(x)^2 + cos(x)^2", {Fraction(0.5)}, 1);
+    test("min(x, y, -x) * 3.2e-1", {Fraction(2.0), Fraction(1.0)}, -0.64);
+    test("x + y", {Fraction(1.0)}, 1);
+    test("SIN(X) * Rate_1 + ABS(-2)", {Fraction(0.0), Fraction(3.0)}, 2);
+    test("(1 + 2))", 1);
+    test("0.123456789 * 0.987654321 * 0.111111111", 0.0135481);
+    test("1/3 + 1/7 + 1/11 + 1/13 + 1/17 + 1/19 + 1/23 + 1/29 + 1/31 + 1/37 + 1/41 + 1/43", 0.94037);
+    test("(-8)^(2/6)", -2);
+    testBatch("x * 2 + y / 4 - abs(-x)", {{1, 2, 3, 4, 5}, {4, 8, 12, 16, 20}}, {2, 4, 6, 8, 10});
+    testBatch("(-x)^(1/3) + sqrt(y) - min(x, y)", {{8, 27, 1}, {4, 9, 0.25}}, {-4, -9, -0.75});
+    testBatch("1/x", {{0, 2}}, {INFINITY, 0.5});
+    testJit("-x * 2 + sin(y)^2 + cos(y)^2 - abs(x) e 1", {{1, 2, 3}, {4, 5, 6}}, {-11, -23, -35});
+    testJit("min(x, 2) + sqrt(x)", {{1, 4, 9}}, {2, 4, 5});
+    testNative({"x * y - 2 ^ y", "min(x, y) + abs(-x)"}, {3, 4}, {-4, 6});
+    testNativeShared("min(x, y, 5) * 2 - min(y, 1)", {3, 4}, 5);
+    testNativeCache("x * 2 + min(x, 1)", {3}, 7);
+    testParallel("x * 2 - sqrt(x) + min(x, 3)", 100003);
+    test("sin(a*b+c) * 2 + sin(a*b+c) - (a*b+c)", {Fraction(0.5), Fraction(2.0), Fraction(1.0)}, 0.727892);
+    testDeduplication("sin(a*b+c) * 2 + sin(a*b+c) - (a*b+c)", 11);
+    testDeduplication("x * x + 2 * 2", 1);
+    testAllocations("min(x, y, 2) * sin(x)^2 + x / y - 3.5 * abs(-y)", {Fraction(0.5), Fraction(3.0)});
+    testNumeric<double>("sin(x)^2 + cos(x)^2 + sqrt(16) - 2^-1 + (-8)^(1/3)", {0.7}, 2.5);
+    testNumeric<long double>("x * 2 - sqrt(x) + min(x, 3) + arcctg(0) * 0", {4.0L}, 9);
+    // Аргумент inf нельзя перевести в Fraction для операции пользователя, поэтому ее ответ - nan
+    testNumeric<double>("min(1/x, 2) + 1", {0.0}, NAN);
+    testNumeric<long double>("min(x, 2) * 0", {1e30L}, NAN);
+    // Имена переменных вызывающего приводятся к нижнему регистру так же, как при разборе
+    testVariables("X * 2 + Speed / 4", {"speed", "x"}, {Fraction(8.0), Fraction(3.0)}, 8);
+    testVariables("a - B", {"B", "A"}, {Fraction(1.0), Fraction(5.0)}, 4);
+    testExact("8888809987242424284282 * 2 + 1/3", "53332859923454545705693/3");
+    testExact("(2^70 + 1) / 3^40 - 2^70 / 3^40", "1/12157665459056928801");
+    testExact("9000000000 * 9000000000 - abs(-1)", "80999999999999999999");
+    testExact("1.5e-30 * 2e+30 + 1e2", "103");
+    testExact("1/1000000000000 * 1/1000000000 * 10^21", "1");
+    testExact("123456789012345678901234.5e-3", "246913578024691357802469/2000");
+    test("2.5e3 + 1e-2 - 2 e 1 + 0.1e+1", 2481.01);
+    testInterval("x^2 - 2*x + sin(y)", {{-1, 2}, {0, 3.2L}}, -4.05837, 7);
+    testInterval("acos(x) + int(x) + abs(x)^(1/3)", {{-8, 0.5L}}, -6.9528, 5.14159);
+    testExtremum("(x-1)^2 + sin(3*x) * y", {{-2, 3}, {0.5L, 1}}, -0.733831, 9.27942);
+    testCache();
+    testStaticStorage("8888809987242424284282 * 3", "26666429961727272852846");
+    testSnapshot();
+    testFolding();
+    testCacheInvalidation();
+    testConcurrentRegistration("x * 2 - sqrt(x) + min(x, 3)", 4000);
+    // Функция, добавленная во время параллельного вычисления, доступна после него
+    test("addedq(3) + addedgb(1)", 8);
+    {
+        // У каждого контекста свои функции и операции, встроенные и общие (min) берутся из общего реестра
+        EvaluationContext first, second;
+        first.AddFunction("fee", [](const vector<Fraction> &a) { return a[0] / Fraction(10.0); }, 3, 1);
+        second.AddFunction("fee", [](const vector<Fraction> &a) { return a[0] / Fraction(4.0); }, 3, 1);
+        second.AddBinaryOperation("%", [](const Fraction &a, const Fraction &b) { return a * b / Fraction(100.0); }, 2);
+
+        testContext("fee(40) + min(1, 2)", first, 5);
+        testContext("fee(40) + 50 % 4 - sin(0)", second, 12);
+        testContext("50 % 4", first, 0);
+        test("fee(40)", 0);
+    }
+    testStatic();
     cout << "Done with " << errors << " errors." << endl;
 }
 
@@ -159,7 +598,9 @@ void input() {
 }
 
 int main() {
+#ifdef _WIN32
     system("chcp 65001");
+#endif
     cout << "Курсовая работа Чернова Степана, КГУ, ИТ-0900022Б" << endl;
 
     Operations &operations = Operations::GetInstance();
@@ -173,5 +614,7 @@ int main() {
     tests();
     input();
 
+#ifdef _WIN32
     system("pause");
+#endif
 }
@@ -0,0 +1,244 @@
+#include "../include/BatchKernels.hpp"
+
+#include <map>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATHPARSER_X86_KERNELS
+
+#include <immintrin.h>
+
+#endif
+
+// Общая реализация BatchKernels::Power для double и long double
+template<typename Number>
+static Number PowerOf(Number a, Number b) {
+    // Наибольший знаменатель показателя, который восстанавливается из числа с плавающей точкой
+    const long long maxDenominator = 1000;
+
+    if (a >= 0 || b == floor(b)) return pow(a, b);
+
+    // Показатель 1/3 в double не точен, поэтому ищем дробь p/q с небольшим знаменателем, равную показателю
+    for (long long q = 2; q <= maxDenominator; q++) {
+        Number p = round(b * (Number) q);
+        if (fabs(b * (Number) q - p) > (Number) 1e-9 * (Number) q) continue;
+
+        if ((long long) p % 2 != 0 && q % 2 == 0) break;
+        Number result = pow(-a, p / (Number) q);
+        return ((long long) p % 2 != 0 ? -result : result);
+    }
+
+    return numeric_limits<Number>::quiet_NaN();
+}
+
+double BatchKernels::Power(double a, double b) { return PowerOf(a, b); }
+
+long double BatchKernels::Power(long double a, long double b) { return PowerOf(a, b); }
+
+template<typename Number>
+Number BatchKernels::Apply(TypeOfKernels kernel, Number a) {
+    const Number halfPi = 1.570796326794896619231321691639751442L;
+
+    switch (kernel) {
+        case negate: return -a;
+        case sine: return sin(a);
+        case cosine: return cos(a);
+        case tangent: return tan(a);
+        case cotangent: return cos(a) / sin(a);
+        case arcsine: return asin(a);
+        case arccosine: return acos(a);
+        case arctangent: return atan(a);
+        case arccotangent: return halfPi - atan(a);
+        case absolute: return fabs(a);
+        case integral: return floor(a);
+        case squareRoot: return sqrt(a);
+        default: return a;
+    }
+}
+
+template<typename Number>
+Number BatchKernels::Apply(TypeOfKernels kernel, Number a, Number b) {
+    switch (kernel) {
+        case add: return a + b;
+        case subtract: return a - b;
+        case multiply: return a * b;
+        case divide: return a / b;
+        case power: return PowerOf(a, b);
+        case exponent: return a * PowerOf((Number) 10, b);
+        default: return a;
+    }
+}
+
+template double BatchKernels::Apply<double>(TypeOfKernels kernel, double a);
+
+template long double BatchKernels::Apply<long double>(TypeOfKernels kernel, long double a);
+
+template double BatchKernels::Apply<double>(TypeOfKernels kernel, double a, double b);
+
+template long double BatchKernels::Apply<long double>(TypeOfKernels kernel, long double a, long double b);
+
+static void UnaryScalar(BatchKernels::TypeOfKernels kernel, double *a, size_t from, size_t size) {
+    for (size_t i = from; i < size; i++) a[i] = BatchKernels::Apply(kernel, a[i]);
+}
+
+static void BinaryScalar(BatchKernels::TypeOfKernels kernel, double *a, const double *b, size_t from, size_t size) {
+    for (size_t i = from; i < size; i++) a[i] = BatchKernels::Apply(kernel, a[i], b[i]);
+}
+
+#ifdef MATHPARSER_X86_KERNELS
+
+static bool HasAvx2() {
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+}
+
+// Векторные функции возвращают количество обработанных элементов, остаток дообрабатывается скалярно
+
+__attribute__((target("avx2"))) static size_t UnaryAvx2(BatchKernels::TypeOfKernels kernel, double *a, size_t size) {
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    size_t end = size - size % 4;
+
+    switch (kernel) {
+        case BatchKernels::negate:
+            for (size_t i = 0; i < end; i += 4) _mm256_storeu_pd(a + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), signMask));
+            return end;
+        case BatchKernels::absolute:
+            for (size_t i = 0; i < end; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_andnot_pd(signMask, _mm256_loadu_pd(a + i)));
+            return end;
+        case BatchKernels::integral:
+            for (size_t i = 0; i < end; i += 4) _mm256_storeu_pd(a + i, _mm256_floor_pd(_mm256_loadu_pd(a + i)));
+            return end;
+        case BatchKernels::squareRoot:
+            for (size_t i = 0; i < end; i += 4) _mm256_storeu_pd(a + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+            return end;
+        default:
+            return 0;
+    }
+}
+
+__attribute__((target("avx2"))) static size_t BinaryAvx2(BatchKernels::TypeOfKernels kernel, double *a, const double *b,
+                                                          size_t size) {
+    size_t end = size - size % 4;
+
+    switch (kernel) {
+        case BatchKernels::add:
+            for (size_t i = 0; i < end; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            return end;
+        case BatchKernels::subtract:
+            for (size_t i = 0; i < end; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            return end;
+        case BatchKernels::multiply:
+            for (size_t i = 0; i < end; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            return end;
+        case BatchKernels::divide:
+            for (size_t i = 0; i < end; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_div_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            return end;
+        default:
+            return 0;
+    }
+}
+
+static size_t UnarySse2(BatchKernels::TypeOfKernels kernel, double *a, size_t size) {
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    size_t end = size - size % 2;
+
+    switch (kernel) {
+        case BatchKernels::negate:
+            for (size_t i = 0; i < end; i += 2) _mm_storeu_pd(a + i, _mm_xor_pd(_mm_loadu_pd(a + i), signMask));
+            return end;
+        case BatchKernels::absolute:
+            for (size_t i = 0; i < end; i += 2) _mm_storeu_pd(a + i, _mm_andnot_pd(signMask, _mm_loadu_pd(a + i)));
+            return end;
+        case BatchKernels::squareRoot:
+            for (size_t i = 0; i < end; i += 2) _mm_storeu_pd(a + i, _mm_sqrt_pd(_mm_loadu_pd(a + i)));
+            return end;
+        default:
+            return 0;
+    }
+}
+
+static size_t BinarySse2(BatchKernels::TypeOfKernels kernel, double *a, const double *b, size_t size) {
+    size_t end = size - size % 2;
+
+    switch (kernel) {
+        case BatchKernels::add:
+            for (size_t i = 0; i < end; i += 2)
+                _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            return end;
+        case BatchKernels::subtract:
+            for (size_t i = 0; i < end; i += 2)
+                _mm_storeu_pd(a + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            return end;
+        case BatchKernels::multiply:
+            for (size_t i = 0; i < end; i += 2)
+                _mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            return end;
+        case BatchKernels::divide:
+            for (size_t i = 0; i < end; i += 2)
+                _mm_storeu_pd(a + i, _mm_div_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            return end;
+        default:
+            return 0;
+    }
+}
+
+#endif
+
+BatchKernels::TypeOfKernels BatchKernels::FindUnaryKernel(const string &name) {
+    if (name == "+") return plus;
+    if (name == "-") return negate;
+    return generic;
+}
+
+BatchKernels::TypeOfKernels BatchKernels::FindBinaryKernel(const string &name) {
+    static const map<string, TypeOfKernels> kernels = {
+            {"+", add},
+            {"-", subtract},
+            {"*", multiply},
+            {"/", divide},
+            {"^", power},
+            {"e", exponent}
+    };
+
+    auto iter = kernels.find(name);
+    return (iter != kernels.end() ? iter->second : generic);
+}
+
+BatchKernels::TypeOfKernels BatchKernels::FindFunctionKernel(const string &name) {
+    for (const auto &[functionName, kernel]: functionKernels)
+        if (functionName == name) return kernel;
+
+    return generic;
+}
+
+void BatchKernels::Fill(double *a, double value, size_t size) {
+    for (size_t i = 0; i < size; i++) a[i] = value;
+}
+
+void BatchKernels::Unary(TypeOfKernels kernel, double *a, size_t size) {
+    size_t processed = 0;
+
+    if (kernel == plus) return;
+
+#ifdef MATHPARSER_X86_KERNELS
+    processed = (HasAvx2() ? UnaryAvx2(kernel, a, size) : UnarySse2(kernel, a, size));
+#endif
+
+    UnaryScalar(kernel, a, processed, size);
+}
+
+void BatchKernels::Binary(TypeOfKernels kernel, double *a, const double *b, size_t size) {
+    size_t processed = 0;
+
+#ifdef MATHPARSER_X86_KERNELS
+    processed = (HasAvx2() ? BinaryAvx2(kernel, a, b, size) : BinarySse2(kernel, a, b, size));
+#endif
+
+    BinaryScalar(kernel, a, b, processed, size);
+}
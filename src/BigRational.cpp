@@ -0,0 +1,673 @@
+#include "../include/BigRational.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+// Разряды длинного числа: по 32 бита, младшие первыми, старший разряд не равен нулю, у нуля разрядов нет
+using Limbs = vector<uint32_t>;
+
+struct BigRational::Big {
+    bool isNegative = false;
+    Limbs numerator;
+    Limbs denominator;
+
+    // Пул длинных значений потока, при завершении потока значения освобождаются
+    struct Pool {
+        vector<Big *> values;
+
+        ~Pool() {
+            for (Big *value: values) delete value;
+            isPoolAlive = false;
+        }
+    };
+
+    static thread_local Pool pool;
+
+    // Пул потока разрушается раньше статических объектов, их длинные значения после этого удаляются сразу
+    static thread_local bool isPoolAlive;
+};
+
+thread_local BigRational::Big::Pool BigRational::Big::pool;
+
+thread_local bool BigRational::Big::isPoolAlive = true;
+
+// Наибольшее количество битов результата целой степени, больше - слишком большое число
+static const unsigned long long maxBitsOfPower = 1 << 18;
+
+// Наибольшее количество длинных значений в пуле одного потока
+static const size_t maxSizeOfPool = 64;
+
+static void Trim(Limbs &a) {
+    while (!a.empty() && a.back() == 0) a.pop_back();
+}
+
+static void Assign(Limbs &a, unsigned __int128 value) {
+    a.clear();
+    for (; value != 0; value >>= 32) a.push_back((uint32_t) value);
+}
+
+// Число разрядов не больше двух, возвращает его значение
+static unsigned long long ToUnsigned(const Limbs &a) {
+    return (a.empty() ? 0 : a[0]) | (a.size() > 1 ? (unsigned long long) a[1] << 32 : 0);
+}
+
+// Число помещается в long long без знака
+static bool IsLongLong(const Limbs &a) { return a.size() < 2 || (a.size() == 2 && a[1] < 0x80000000u); }
+
+static bool IsLongLong(__int128 a) {
+    return (a >= numeric_limits<long long>::min() && a <= numeric_limits<long long>::max());
+}
+
+static int CompareLimbs(const Limbs &a, const Limbs &b) {
+    if (a.size() != b.size()) return (a.size() < b.size() ? -1 : 1);
+
+    for (size_t i = a.size(); i-- > 0;)
+        if (a[i] != b[i]) return (a[i] < b[i] ? -1 : 1);
+
+    return 0;
+}
+
+// result = a + b, result не совпадает с a и b
+static void AddLimbs(const Limbs &a, const Limbs &b, Limbs &result) {
+    const Limbs &longer = (a.size() >= b.size() ? a : b), &shorter = (a.size() >= b.size() ? b : a);
+    unsigned long long carry = 0;
+
+    result.resize(longer.size() + 1);
+    for (size_t i = 0; i < longer.size(); i++) {
+        carry += (unsigned long long) longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        result[i] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    result[longer.size()] = (uint32_t) carry;
+
+    Trim(result);
+}
+
+// result = a - b, a не меньше b, result не совпадает с a и b
+static void SubtractLimbs(const Limbs &a, const Limbs &b, Limbs &result) {
+    long long borrow = 0;
+
+    result.resize(a.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        long long difference = (long long) a[i] - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = (difference < 0);
+        result[i] = (uint32_t) (difference + (borrow << 32));
+    }
+
+    Trim(result);
+}
+
+// result = a * b, result не совпадает с a и b
+static void MultiplyLimbs(const Limbs &a, const Limbs &b, Limbs &result) {
+    result.assign(a.size() + b.size(), 0);
+    if (a.empty() || b.empty()) {
+        result.clear();
+        return;
+    }
+
+    for (size_t i = 0; i < a.size(); i++) {
+        unsigned long long carry = 0;
+
+        for (size_t j = 0; j < b.size(); j++) {
+            carry += (unsigned long long) a[i] * b[j] + result[i + j];
+            result[i + j] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        result[i + b.size()] = (uint32_t) carry;
+    }
+
+    Trim(result);
+}
+
+// a = a * factor + addend
+static void MultiplyAddSmall(Limbs &a, uint32_t factor, uint32_t addend) {
+    unsigned long long carry = addend;
+
+    for (auto &limb: a) {
+        carry += (unsigned long long) limb * factor;
+        limb = (uint32_t) carry;
+        carry >>= 32;
+    }
+    if (carry != 0) a.push_back((uint32_t) carry);
+}
+
+// a = a / divisor, возвращает остаток
+static uint32_t DivideSmall(Limbs &a, uint32_t divisor) {
+    unsigned long long remainder = 0;
+
+    for (size_t i = a.size(); i-- > 0;) {
+        remainder = (remainder << 32) | a[i];
+        a[i] = (uint32_t) (remainder / divisor);
+        remainder %= divisor;
+    }
+
+    Trim(a);
+    return (uint32_t) remainder;
+}
+
+// Деление с остатком по алгоритму D Кнута: u = quotient * v + remainder, v не равно нулю,
+// результаты не совпадают с u и v
+static void DivideLimbs(const Limbs &u, const Limbs &v, Limbs &quotient, Limbs &remainder) {
+    thread_local Limbs un, vn;
+
+    if (CompareLimbs(u, v) < 0) {
+        quotient.clear();
+        remainder = u;
+        return;
+    }
+
+    if (v.size() == 1) {
+        quotient = u;
+        remainder.assign(1, DivideSmall(quotient, v[0]));
+        Trim(remainder);
+        return;
+    }
+
+    size_t n = v.size(), m = u.size();
+    // Делитель сдвигается так, чтобы старший бит старшего разряда был единицей, делимое - вместе с ним
+    int shift = __builtin_clz(v[n - 1]);
+
+    vn.resize(n);
+    for (size_t i = n - 1; i > 0; i--)
+        vn[i] = (uint32_t) (((unsigned long long) v[i] << shift) | ((unsigned long long) v[i - 1] >> (32 - shift)));
+    vn[0] = v[0] << shift;
+
+    un.resize(m + 1);
+    un[m] = (uint32_t) ((unsigned long long) u[m - 1] >> (32 - shift));
+    for (size_t i = m - 1; i > 0; i--)
+        un[i] = (uint32_t) (((unsigned long long) u[i] << shift) | ((unsigned long long) u[i - 1] >> (32 - shift)));
+    un[0] = u[0] << shift;
+
+    quotient.assign(m - n + 1, 0);
+
+    for (size_t j = m - n + 1; j-- > 0;) {
+        // Оценка цифры частного по двум старшим разрядам, она больше верной не более чем на 2
+        unsigned long long numerator = ((unsigned long long) un[j + n] << 32) | un[j + n - 1];
+        unsigned long long estimate = numerator / vn[n - 1], rest = numerator % vn[n - 1];
+
+        while (estimate >> 32 != 0 || estimate * vn[n - 2] > ((rest << 32) | un[j + n - 2])) {
+            estimate--;
+            rest += vn[n - 1];
+            if (rest >> 32 != 0) break;
+        }
+
+        // Вычитаем estimate * vn из текущей части делимого
+        long long borrow = 0, difference;
+        for (size_t i = 0; i < n; i++) {
+            unsigned long long product = estimate * vn[i];
+            difference = (long long) un[i + j] - borrow - (long long) (product & 0xFFFFFFFFu);
+            un[i + j] = (uint32_t) difference;
+            borrow = (long long) (product >> 32) - (difference >> 32);
+        }
+        difference = (long long) un[j + n] - borrow;
+        un[j + n] = (uint32_t) difference;
+
+        quotient[j] = (uint32_t) estimate;
+
+        // Оценка оказалась больше на единицу: возвращаем делитель
+        if (difference < 0) {
+            quotient[j]--;
+            unsigned long long carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                carry += (unsigned long long) un[i + j] + vn[i];
+                un[i + j] = (uint32_t) carry;
+                carry >>= 32;
+            }
+            un[j + n] += (uint32_t) carry;
+        }
+    }
+
+    remainder.resize(n);
+    for (size_t i = 0; i < n; i++)
+        remainder[i] = (uint32_t) (((unsigned long long) un[i] >> shift) |
+                                   ((unsigned long long) un[i + 1] << (32 - shift)));
+
+    Trim(quotient);
+    Trim(remainder);
+}
+
+// Двоичный алгоритм наибольшего общего делителя (алгоритм Стейна)
+static unsigned long long GCD(unsigned long long a, unsigned long long b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+
+    while (b != 0) {
+        b >>= __builtin_ctzll(b);
+        if (a > b) swap(a, b);
+        b -= a;
+    }
+
+    return a << shift;
+}
+
+// Наибольший общий делитель длинных чисел: алгоритм Евклида, пока числа длиннее 64 бит, затем двоичный
+static void GCD(const Limbs &a, const Limbs &b, Limbs &result) {
+    thread_local Limbs x, y, quotient, remainder;
+
+    x = a;
+    y = b;
+
+    while (!y.empty()) {
+        if (x.size() <= 2 && y.size() <= 2) {
+            Assign(result, GCD(ToUnsigned(x), ToUnsigned(y)));
+            return;
+        }
+
+        DivideLimbs(x, y, quotient, remainder);
+        swap(x, y);
+        swap(y, remainder);
+    }
+
+    result = x;
+}
+
+// Значение числа в виде value * 2^exponent, value содержит три старших разряда
+static long double ToLongDouble(const Limbs &a, long &exponent) {
+    size_t start = (a.size() > 3 ? a.size() - 3 : 0);
+    long double value = 0;
+
+    for (size_t i = a.size(); i-- > start;) value = value * 4294967296.0L + a[i];
+    exponent = (long) (32 * start);
+
+    return value;
+}
+
+// Количество значащих битов
+static unsigned long long CountBits(const Limbs &a) {
+    return (a.empty() ? 0 : 32 * a.size() - __builtin_clz(a.back()));
+}
+
+static unsigned long long CountBits(unsigned long long a) { return (a == 0 ? 0 : 64 - __builtin_clzll(a)); }
+
+BigRational::Big *BigRational::Allocate() {
+    if (!Big::isPoolAlive || Big::pool.values.empty()) return new Big();
+
+    Big *value = Big::pool.values.back();
+    Big::pool.values.pop_back();
+
+    return value;
+}
+
+void BigRational::Release(Big *value) {
+    if (!Big::isPoolAlive || Big::pool.values.size() >= maxSizeOfPool) {
+        delete value;
+        return;
+    }
+
+    Big::pool.values.push_back(value);
+}
+
+BigRational BigRational::Make(__int128 numerator, __int128 denominator) {
+    if (denominator < 0) {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+
+    if (IsLongLong(numerator) && IsLongLong(denominator)) {
+        BigRational result;
+        result.numerator = (long long) numerator;
+        result.denominator = (long long) denominator;
+        return result;
+    }
+
+    // Дробь не помещается в long long: сокращение и переход в длинное представление выполняет FromParts
+    thread_local Limbs numeratorParts, denominatorParts;
+    Assign(numeratorParts, (unsigned __int128) (numerator < 0 ? -numerator : numerator));
+    Assign(denominatorParts, (unsigned __int128) denominator);
+
+    return FromParts(numerator < 0, numeratorParts, denominatorParts);
+}
+
+BigRational BigRational::FromParts(bool isNegative, Limbs &numerator, Limbs &denominator) {
+    thread_local Limbs gcd, quotient, remainder;
+    BigRational result;
+
+    if (numerator.empty()) return result;
+
+    GCD(numerator, denominator, gcd);
+    if (gcd.size() != 1 || gcd[0] != 1) {
+        DivideLimbs(numerator, gcd, quotient, remainder);
+        swap(numerator, quotient);
+        DivideLimbs(denominator, gcd, quotient, remainder);
+        swap(denominator, quotient);
+    }
+
+    if (IsLongLong(numerator) && IsLongLong(denominator)) {
+        auto value = (long long) ToUnsigned(numerator);
+        result.numerator = (isNegative ? -value : value);
+        result.denominator = (long long) ToUnsigned(denominator);
+        return result;
+    }
+
+    // Разряды меняются местами с разрядами значения из пула, поэтому память обеих сторон переиспользуется
+    result.big = Allocate();
+    result.big->isNegative = isNegative;
+    swap(result.big->numerator, numerator);
+    swap(result.big->denominator, denominator);
+
+    return result;
+}
+
+void BigRational::GetParts(bool &isNegative, const Limbs *&numeratorParts, const Limbs *&denominatorParts,
+                           Limbs &numeratorStorage, Limbs &denominatorStorage) const {
+    if (big) {
+        isNegative = big->isNegative;
+        numeratorParts = &big->numerator;
+        denominatorParts = &big->denominator;
+        return;
+    }
+
+    isNegative = (numerator < 0);
+    Assign(numeratorStorage, (unsigned __int128) (numerator < 0 ? -(__int128) numerator : numerator));
+    Assign(denominatorStorage, (unsigned __int128) denominator);
+    numeratorParts = &numeratorStorage;
+    denominatorParts = &denominatorStorage;
+}
+
+BigRational::BigRational(const Fraction &fraction) {
+    *this = Make(fraction.GetNumerator(), fraction.GetDenominator());
+}
+
+BigRational::BigRational(const long double &number) {
+    if (!isfinite(number)) throw runtime_error("Ошибка вычисления. Проверьте выражение");
+    if (number == 0) return;
+
+    // number = mantissa * 2^exponent, mantissa - целое число из 64 бит
+    int exponent;
+    long double fraction = frexpl(fabsl(number), &exponent);
+    auto mantissa = (unsigned long long) ldexpl(fraction, 64);
+    exponent -= 64;
+
+    int zeros = __builtin_ctzll(mantissa);
+    mantissa >>= zeros;
+    exponent += zeros;
+
+    Limbs numeratorParts, denominatorParts;
+    Assign(numeratorParts, mantissa);
+    Assign(denominatorParts, 1);
+
+    // Умножение на степень двойки - сдвиг на целые разряды и на биты внутри разряда
+    Limbs &shifted = (exponent >= 0 ? numeratorParts : denominatorParts);
+    for (int bits = abs(exponent); bits > 0; bits -= min(bits, 31)) MultiplyAddSmall(shifted, 1u << min(bits, 31), 0);
+
+    *this = FromParts(number < 0, numeratorParts, denominatorParts);
+}
+
+BigRational::BigRational(const string &str) {
+    Limbs numeratorParts, denominatorParts;
+    long long exponent = 0;
+    bool isDecimal = false, hasDigits = false;
+    size_t position = 0;
+
+    Assign(denominatorParts, 1);
+
+    for (; position < str.size() && str[position] != 'e' && str[position] != 'E'; position++) {
+        char symbol = str[position];
+        if (symbol == '.' && !isDecimal) {
+            isDecimal = true;
+            continue;
+        }
+        if (symbol < '0' || symbol > '9') throw runtime_error("Ошибка. Некорректное число " + str);
+
+        MultiplyAddSmall(numeratorParts, 10, (uint32_t) (symbol - '0'));
+        if (isDecimal) exponent--;
+        hasDigits = true;
+    }
+
+    if (!hasDigits) throw runtime_error("Ошибка. Некорректное число " + str);
+
+    // Показатель степени разбирается по тем же правилам, что и в Fraction::ScanDecimal
+    if (position < str.size()) {
+        Fraction::Decimal decimal = Fraction::ScanDecimal("1" + str.substr(position));
+        if (decimal.length != str.size() - position + 1) throw runtime_error("Ошибка. Некорректное число " + str);
+        exponent += decimal.exponent;
+    }
+
+    Trim(numeratorParts);
+    *this = FromParts(false, numeratorParts, denominatorParts);
+
+    // Степень 10 вычисляется возведением в квадрат, слишком большой порядок - исключение из Power
+    if (exponent != 0 && !(numerator == 0 && !big)) {
+        BigRational scale = Power(BigRational(10LL), BigRational(exponent < 0 ? -exponent : exponent));
+        *this = (exponent < 0 ? *this / scale : *this * scale);
+    }
+}
+
+void BigRational::CopyBig(const BigRational &other) {
+    if (!big) big = Allocate();
+    *big = *other.big;
+}
+
+bool BigRational::IsSmall() const { return !big; }
+
+long long BigRational::GetNumerator() const {
+    if (big) throw runtime_error("Ошибка. Слишком большое число");
+    return numerator;
+}
+
+long long BigRational::GetDenominator() const {
+    if (big) throw runtime_error("Ошибка. Слишком большое число");
+    return denominator;
+}
+
+bool BigRational::IsInteger() const {
+    if (big) return (big->denominator.size() == 1 && big->denominator[0] == 1);
+    return (numerator % denominator == 0);
+}
+
+string BigRational::ToString() const {
+    bool isNegative;
+    const Limbs *numeratorParts, *denominatorParts;
+    Limbs numeratorStorage, denominatorStorage;
+
+    // Короткое число может быть не сокращено, а запись должна быть несократимой
+    if (!big) {
+        auto gcd = (long long) GCD((unsigned long long) llabs(numerator), (unsigned long long) denominator);
+        BigRational reduced;
+        reduced.numerator = numerator / gcd;
+        reduced.denominator = denominator / gcd;
+        reduced.GetParts(isNegative, numeratorParts, denominatorParts, numeratorStorage, denominatorStorage);
+    } else GetParts(isNegative, numeratorParts, denominatorParts, numeratorStorage, denominatorStorage);
+
+    // Десятичная запись разрядов: делим на 10^9 и записываем остатки с конца
+    auto toDecimal = [](Limbs value) {
+        string text;
+
+        do {
+            uint32_t chunk = DivideSmall(value, 1000000000u);
+            for (int i = 0; i < 9 && (!value.empty() || chunk != 0 || i == 0); i++) {
+                text += (char) ('0' + chunk % 10);
+                chunk /= 10;
+            }
+        } while (!value.empty());
+
+        reverse(text.begin(), text.end());
+        return text;
+    };
+
+    string text = (isNegative ? "-" : "") + toDecimal(*numeratorParts);
+    if (denominatorParts->size() != 1 || (*denominatorParts)[0] != 1) text += "/" + toDecimal(*denominatorParts);
+
+    return text;
+}
+
+Fraction BigRational::ToFraction() const {
+    if (big) return Fraction((long double) *this);
+
+    Fraction result;
+    result.SetNumerator(numerator);
+    result.SetDenominator(denominator);
+    return result;
+}
+
+BigRational::operator long double() const {
+    if (!big) return (long double) numerator / denominator;
+
+    long numeratorExponent, denominatorExponent;
+    long double value = ToLongDouble(big->numerator, numeratorExponent) /
+                        ToLongDouble(big->denominator, denominatorExponent);
+    value = ldexpl(value, (int) max<long>(min<long>(numeratorExponent - denominatorExponent, INT32_MAX), INT32_MIN));
+
+    return (big->isNegative ? -value : value);
+}
+
+BigRational::operator double() const { return (double) (long double) *this; }
+
+BigRational BigRational::Add(const BigRational &a, const BigRational &b, bool isSubtraction) {
+    if (!a.big && !b.big) {
+        __int128 left = (__int128) a.numerator * b.denominator, right = (__int128) a.denominator * b.numerator;
+        return Make(isSubtraction ? left - right : left + right, (__int128) a.denominator * b.denominator);
+    }
+
+    thread_local Limbs firstStorage[2], secondStorage[2], first, second, numeratorParts, denominatorParts;
+    bool isFirstNegative, isSecondNegative;
+    const Limbs *firstNumerator, *firstDenominator, *secondNumerator, *secondDenominator;
+
+    a.GetParts(isFirstNegative, firstNumerator, firstDenominator, firstStorage[0], firstStorage[1]);
+    b.GetParts(isSecondNegative, secondNumerator, secondDenominator, secondStorage[0], secondStorage[1]);
+    if (isSubtraction && (secondNumerator->size() != 0)) isSecondNegative = !isSecondNegative;
+
+    MultiplyLimbs(*firstNumerator, *secondDenominator, first);
+    MultiplyLimbs(*secondNumerator, *firstDenominator, second);
+    MultiplyLimbs(*firstDenominator, *secondDenominator, denominatorParts);
+
+    bool isNegative = isFirstNegative;
+    if (isFirstNegative == isSecondNegative) AddLimbs(first, second, numeratorParts);
+    else if (CompareLimbs(first, second) >= 0) SubtractLimbs(first, second, numeratorParts);
+    else {
+        SubtractLimbs(second, first, numeratorParts);
+        isNegative = isSecondNegative;
+    }
+
+    return FromParts(isNegative, numeratorParts, denominatorParts);
+}
+
+BigRational BigRational::operator-() const {
+    if (!big) return Make(-(__int128) numerator, denominator);
+
+    BigRational result(*this);
+    result.big->isNegative = !big->isNegative;
+    return result;
+}
+
+BigRational BigRational::Multiply(const BigRational &a, const BigRational &b, bool isDivision) {
+    if (!a.big && !b.big) {
+        if (isDivision) return Make((__int128) a.numerator * b.denominator, (__int128) a.denominator * b.numerator);
+        return Make((__int128) a.numerator * b.numerator, (__int128) a.denominator * b.denominator);
+    }
+
+    thread_local Limbs firstStorage[2], secondStorage[2], numeratorParts, denominatorParts;
+    bool isFirstNegative, isSecondNegative;
+    const Limbs *firstNumerator, *firstDenominator, *secondNumerator, *secondDenominator;
+
+    a.GetParts(isFirstNegative, firstNumerator, firstDenominator, firstStorage[0], firstStorage[1]);
+    b.GetParts(isSecondNegative, secondNumerator, secondDenominator, secondStorage[0], secondStorage[1]);
+    // Деление - умножение на перевернутую дробь
+    if (isDivision) swap(secondNumerator, secondDenominator);
+
+    MultiplyLimbs(*firstNumerator, *secondNumerator, numeratorParts);
+    MultiplyLimbs(*firstDenominator, *secondDenominator, denominatorParts);
+
+    return FromParts(isFirstNegative != isSecondNegative, numeratorParts, denominatorParts);
+}
+
+BigRational BigRational::operator/(const BigRational &other) const {
+    if (!other.big && other.numerator == 0) throw runtime_error("Ошибка вычисления. Деление на ноль");
+    return Multiply(*this, other, true);
+}
+
+int BigRational::Compare(const BigRational &a, const BigRational &b) {
+    if (!a.big && !b.big) {
+        __int128 left = (__int128) a.numerator * b.denominator, right = (__int128) b.numerator * a.denominator;
+        return (left < right ? -1 : (left > right ? 1 : 0));
+    }
+
+    thread_local Limbs firstStorage[2], secondStorage[2], first, second;
+    bool isFirstNegative, isSecondNegative;
+    const Limbs *firstNumerator, *firstDenominator, *secondNumerator, *secondDenominator;
+
+    a.GetParts(isFirstNegative, firstNumerator, firstDenominator, firstStorage[0], firstStorage[1]);
+    b.GetParts(isSecondNegative, secondNumerator, secondDenominator, secondStorage[0], secondStorage[1]);
+
+    // Сначала сравниваются знаки, у нуля знак 0
+    int firstSign = (firstNumerator->empty() ? 0 : (isFirstNegative ? -1 : 1));
+    int secondSign = (secondNumerator->empty() ? 0 : (isSecondNegative ? -1 : 1));
+    if (firstSign != secondSign) return (firstSign < secondSign ? -1 : 1);
+
+    MultiplyLimbs(*firstNumerator, *secondDenominator, first);
+    MultiplyLimbs(*secondNumerator, *firstDenominator, second);
+
+    int result = CompareLimbs(first, second);
+    return (firstSign < 0 ? -result : result);
+}
+
+bool BigRational::operator<(const BigRational &other) const { return Compare(*this, other) < 0; }
+
+bool BigRational::operator<=(const BigRational &other) const { return Compare(*this, other) <= 0; }
+
+bool BigRational::operator>(const BigRational &other) const { return Compare(*this, other) > 0; }
+
+bool BigRational::operator>=(const BigRational &other) const { return Compare(*this, other) >= 0; }
+
+bool BigRational::operator==(const BigRational &other) const { return Compare(*this, other) == 0; }
+
+bool BigRational::operator!=(const BigRational &other) const { return Compare(*this, other) != 0; }
+
+BigRational BigRational::Power(const BigRational &a, const BigRational &b) {
+    if (b.IsInteger() && !b.big) {
+        long long exponent = b.numerator / b.denominator;
+        unsigned long long absoluteExponent = (exponent < 0 ? 0 - (unsigned long long) exponent : exponent);
+
+        if (exponent < 0 && a == BigRational()) throw runtime_error("Ошибка вычисления. Деление на ноль");
+
+        // Оценка размера результата: количество битов основания, умноженное на показатель
+        unsigned long long bitsOfBase;
+        if (a.big) bitsOfBase = max(CountBits(a.big->numerator), CountBits(a.big->denominator));
+        else bitsOfBase = max(CountBits((unsigned long long) llabs(a.numerator)), CountBits(a.denominator));
+        if (bitsOfBase > 1 && absoluteExponent > maxBitsOfPower / bitsOfBase)
+            throw runtime_error("Ошибка. Слишком большое число");
+
+        // Возведение в квадрат: показатель просматривается по битам от младшего к старшему
+        BigRational result(1LL), base(a);
+        while (absoluteExponent != 0) {
+            if (absoluteExponent & 1) result = result * base;
+            absoluteExponent >>= 1;
+            if (absoluteExponent != 0) base = base * base;
+        }
+
+        return (exponent < 0 ? BigRational(1LL) / result : result);
+    }
+
+    // Дробная степень коротких чисел вычисляется так же, как у Fraction
+    if (!a.big && !b.big) return BigRational(Fraction::Power(a.ToFraction(), b.ToFraction()));
+
+    // Длинное основание или показатель: степень вычисляется в long double по тем же правилам знака
+    bool isNegative;
+    const Limbs *numeratorParts, *denominatorParts;
+    Limbs numeratorStorage, denominatorStorage;
+    b.GetParts(isNegative, numeratorParts, denominatorParts, numeratorStorage, denominatorStorage);
+
+    bool isNumeratorOdd = (!numeratorParts->empty() && ((*numeratorParts)[0] & 1));
+    bool isDenominatorOdd = ((*denominatorParts)[0] & 1);
+
+    // Короткий показатель может быть не сокращен
+    if (!b.big) {
+        auto gcd = GCD((unsigned long long) llabs(b.numerator), (unsigned long long) b.denominator);
+        isNumeratorOdd = ((b.numerator / (long long) gcd) & 1);
+        isDenominatorOdd = ((b.denominator / (long long) gcd) & 1);
+    }
+    auto base = (long double) a;
+
+    if (base < 0 && isNumeratorOdd && !isDenominatorOdd)
+        throw runtime_error("Ошибка вычисления. Извлечение четного корня из отрицательного числа");
+
+    long double result = powl(fabsl(base), (long double) b);
+    if (!isfinite(result)) throw runtime_error("Ошибка. Слишком большое число");
+
+    return BigRational(base < 0 && isNumeratorOdd ? -result : result);
+}
@@ -0,0 +1,897 @@
+#include "../include/CompiledExpression.hpp"
+#include "../include/ThreadPool.hpp"
+
+#include <map>
+#include <queue>
+
+Fraction CompiledExpression::Eval() const { return Eval(span<const Fraction>()); }
+
+BigRational CompiledExpression::EvalExact() const { return EvalExact(span<const BigRational>()); }
+
+// Исполнение байт-кода: с GCC и Clang используется прямая шитая диспетчеризация через таблицу адресов меток,
+// каждая команда сама переходит к обработчику следующей; иначе - обычный switch в цикле
+#if defined(__GNUC__)
+#define MATHPARSER_COMMAND(name) name##Handler:
+#define MATHPARSER_NEXT() goto *handlers[(++command)->code]
+#else
+#define MATHPARSER_COMMAND(name) case name:
+#define MATHPARSER_NEXT() command++; continue
+#endif
+
+Fraction CompiledExpression::Eval(span<const Fraction> values) const {
+    thread_local EvaluationArena arena;
+
+    // Функция пользователя может сама вычислять выражения, тогда рабочая память потока уже занята
+    if (arena.IsBusy()) {
+        EvaluationArena nestedArena;
+        return Eval(values, nestedArena);
+    }
+
+    return Eval(values, arena);
+}
+
+Fraction CompiledExpression::Eval(span<const Fraction> values, EvaluationArena &arena) const {
+    if (values.size() < variables.size())
+        throw runtime_error("Ошибка. Не задано значение переменной " + variables[values.size()]);
+
+    if (hasLargeConstants) throw runtime_error("Ошибка. Слишком большое число");
+
+    arena.Reserve(numberOfCommandRegisters, maxNumberOfArguments);
+
+    // Рабочая память освобождается и при исключении из операции
+    struct Guard {
+        bool &isBusy;
+
+        ~Guard() { isBusy = false; }
+    } guard{arena.isBusy};
+    arena.isBusy = true;
+
+    Fraction *registers = arena.registers.data();
+    vector<Fraction> &args = arena.args;
+    static const Fraction ten(10.0);
+    const Command *command = commands.data();
+
+#if defined(__GNUC__)
+    // Адреса обработчиков в порядке TypeOfCommands
+    static const void *const handlers[] = {
+            &&loadConstantHandler, &&loadVariableHandler, &&addHandler, &&subtractHandler, &&multiplyHandler,
+            &&divideHandler, &&powerHandler, &&exponentHandler, &&negateHandler, &&addConstantHandler,
+            &&subtractConstantHandler, &&multiplyConstantHandler, &&divideConstantHandler, &&powerConstantHandler,
+            &&constantSubtractHandler, &&constantDivideHandler, &&constantPowerHandler, &&multiplyAddHandler,
+            &&negatePowerHandler, &&negatePowerConstantHandler, &&callUnaryHandler, &&callBinaryHandler,
+            &&callFunctionHandler, &&stopHandler
+    };
+
+    goto *handlers[command->code];
+#else
+    for (;;) {
+        switch (command->code) {
+#endif
+    MATHPARSER_COMMAND(loadConstant)
+    registers[command->result] = constants[command->a];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(loadVariable)
+    registers[command->result] = values[command->a];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(add)
+    registers[command->result] = registers[command->a] + registers[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(subtract)
+    registers[command->result] = registers[command->a] - registers[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(multiply)
+    registers[command->result] = registers[command->a] * registers[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(divide)
+    registers[command->result] = registers[command->a] / registers[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(power)
+    registers[command->result] = Fraction::Power(registers[command->a], registers[command->b]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(exponent)
+    registers[command->result] = registers[command->a] * Fraction::Power(ten, registers[command->b]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(negate)
+    registers[command->result] = -registers[command->a];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(addConstant)
+    registers[command->result] = registers[command->a] + constants[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(subtractConstant)
+    registers[command->result] = registers[command->a] - constants[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(multiplyConstant)
+    registers[command->result] = registers[command->a] * constants[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(divideConstant)
+    registers[command->result] = registers[command->a] / constants[command->b];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(powerConstant)
+    registers[command->result] = Fraction::Power(registers[command->a], constants[command->b]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(constantSubtract)
+    registers[command->result] = constants[command->b] - registers[command->a];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(constantDivide)
+    registers[command->result] = constants[command->b] / registers[command->a];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(constantPower)
+    registers[command->result] = Fraction::Power(constants[command->b], registers[command->a]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(multiplyAdd)
+    registers[command->result] = registers[command->a] * registers[command->b] + registers[command->c];
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(negatePower)
+    registers[command->result] = -Fraction::Power(registers[command->a], registers[command->b]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(negatePowerConstant)
+    registers[command->result] = -Fraction::Power(registers[command->a], constants[command->b]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(callUnary)
+    registers[command->result] = unaryOperations[command->b](registers[command->a]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(callBinary)
+    registers[command->result] = binaryOperations[command->c](registers[command->a], registers[command->b]);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(callFunction)
+    args.clear();
+    for (uint32_t i = 0; i < command->b; i++) args.push_back(registers[commandOperands[command->a + i]]);
+    registers[command->result] = functions[command->c](args);
+    MATHPARSER_NEXT();
+
+    MATHPARSER_COMMAND(stop)
+    return registers[command->result];
+#if !defined(__GNUC__)
+        }
+    }
+#endif
+}
+
+#undef MATHPARSER_COMMAND
+#undef MATHPARSER_NEXT
+
+template<typename Number>
+Number CompiledExpression::EvalAs(span<const Number> values) const {
+    if constexpr (is_same_v<Number, Fraction>) return Eval(values);
+    else {
+        thread_local vector<Number> threadRegisters;
+        thread_local bool isBusy = false;
+        vector<Number> nestedRegisters;
+
+        if (values.size() < variables.size())
+            throw runtime_error("Ошибка. Не задано значение переменной " + variables[values.size()]);
+
+        // Функция пользователя может сама вычислять выражения, тогда регистры потока уже заняты
+        vector<Number> &registers = (isBusy ? nestedRegisters : threadRegisters);
+        if (registers.size() < numberOfRegisters) registers.resize(numberOfRegisters);
+
+        struct Guard {
+            bool &isBusy;
+            bool wasBusy;
+
+            ~Guard() { isBusy = wasBusy; }
+        } guard{isBusy, isBusy};
+        isBusy = true;
+
+        const Number *constantValues;
+        if constexpr (is_same_v<Number, double>) constantValues = doubleConstants.data();
+        else if constexpr (is_same_v<Number, Interval>) constantValues = intervalConstants.data();
+        else constantValues = longDoubleConstants.data();
+
+        for (const auto &iter: instructions) {
+            const size_t *operand = operands.data() + iter.firstOperand;
+            Number &target = registers[iter.result];
+
+            switch (iter.type) {
+                case constant:
+                    target = constantValues[iter.index];
+                    continue;
+
+                case variable:
+                    target = values[iter.index];
+                    continue;
+
+                default:
+                    break;
+            }
+
+            if (iter.kernel != BatchKernels::generic) {
+                if constexpr (is_same_v<Number, Interval>) {
+                    if (iter.type == binaryOperation)
+                        target = Interval::Apply(iter.kernel, registers[operand[0]], registers[operand[1]]);
+                    else target = Interval::Apply(iter.kernel, registers[operand[0]]);
+                } else {
+                    if (iter.type == binaryOperation)
+                        target = BatchKernels::Apply(iter.kernel, registers[operand[0]], registers[operand[1]]);
+                    else target = BatchKernels::Apply(iter.kernel, registers[operand[0]]);
+                }
+                continue;
+            }
+
+            if constexpr (is_same_v<Number, Interval>) {
+                vector<Interval> args;
+                for (size_t i = 0; i < iter.numberOfArguments; i++) args.push_back(registers[operand[i]]);
+                target = ApplyInterval(iter, args);
+            } else {
+                // Операции пользователя принимают только Fraction. Аргумент или ответ, который нельзя перевести
+                // (inf, nan, слишком большое число), и ошибка самой операции дают nan, как в EvalBatch
+                try {
+                    vector<Fraction> args;
+                    for (size_t i = 0; i < iter.numberOfArguments; i++)
+                        args.push_back(Fraction((long double) registers[operand[i]]));
+
+                    Fraction value;
+                    if (iter.type == unaryOperation) value = unaryOperations[iter.index](args[0]);
+                    else if (iter.type == binaryOperation) value = binaryOperations[iter.index](args[0], args[1]);
+                    else value = functions[iter.index](args);
+
+                    target = (Number) (long double) value;
+                } catch (exception &error) {
+                    target = numeric_limits<Number>::quiet_NaN();
+                }
+            }
+        }
+
+        return registers[instructions.back().result];
+    }
+}
+
+template double CompiledExpression::EvalAs<double>(span<const double> values) const;
+
+template long double CompiledExpression::EvalAs<long double>(span<const long double> values) const;
+
+template Interval CompiledExpression::EvalAs<Interval>(span<const Interval> values) const;
+
+template Fraction CompiledExpression::EvalAs<Fraction>(span<const Fraction> values) const;
+
+BigRational CompiledExpression::EvalExact(span<const BigRational> values) const {
+    vector<BigRational> registers(numberOfRegisters), args;
+
+    if (values.size() < variables.size())
+        throw runtime_error("Ошибка. Не задано значение переменной " + variables[values.size()]);
+
+    for (const auto &iter: instructions) {
+        const size_t *operand = operands.data() + iter.firstOperand;
+
+        switch (iter.type) {
+            case constant:
+                registers[iter.result] = exactConstants[iter.index];
+                continue;
+
+            case variable:
+                registers[iter.result] = values[iter.index];
+                continue;
+
+            default:
+                break;
+        }
+
+        args.clear();
+        for (size_t i = 0; i < iter.numberOfArguments; i++) args.push_back(registers[operand[i]]);
+        registers[iter.result] = ApplyExact(iter, args);
+    }
+
+    return registers[instructions.back().result];
+}
+
+BigRational CompiledExpression::ApplyExact(const Instruction &instruction, const vector<BigRational> &args) const {
+    static const BigRational ten(10LL);
+
+    switch (instruction.kernel) {
+        case BatchKernels::plus: return args[0];
+        case BatchKernels::negate: return -args[0];
+        case BatchKernels::add: return args[0] + args[1];
+        case BatchKernels::subtract: return args[0] - args[1];
+        case BatchKernels::multiply: return args[0] * args[1];
+        case BatchKernels::divide: return args[0] / args[1];
+        case BatchKernels::power: return BigRational::Power(args[0], args[1]);
+        case BatchKernels::exponent: return args[0] * BigRational::Power(ten, args[1]);
+        default: break;
+    }
+
+    // У остальных операций есть только реализация через Fraction
+    vector<Fraction> fractions;
+    for (const auto &iter: args) fractions.push_back(iter.ToFraction());
+
+    switch (instruction.type) {
+        case unaryOperation: return BigRational(unaryOperations[instruction.index](fractions[0]));
+        case binaryOperation: return BigRational(binaryOperations[instruction.index](fractions[0], fractions[1]));
+        default: return BigRational(functions[instruction.index](fractions));
+    }
+}
+
+Interval CompiledExpression::ApplyInterval(const Instruction &instruction, const vector<Interval> &args) const {
+    if (instruction.kernel != BatchKernels::generic) {
+        if (instruction.numberOfArguments == 2) return Interval::Apply(instruction.kernel, args[0], args[1]);
+        return Interval::Apply(instruction.kernel, args[0]);
+    }
+
+    // Операция пользователя известна только в точках, ее значение расширяется на погрешность перевода в дробь
+    vector<Fraction> fractions;
+    for (const auto &iter: args) {
+        if (iter.IsEmpty()) return iter;
+        if (!iter.IsPoint())
+            throw runtime_error("Ошибка вычисления. У операции пользователя нет интервального вычисления");
+        fractions.emplace_back(iter.GetLower());
+    }
+
+    Fraction value;
+    switch (instruction.type) {
+        case unaryOperation:
+            value = unaryOperations[instruction.index](fractions[0]);
+            break;
+        case binaryOperation:
+            value = binaryOperations[instruction.index](fractions[0], fractions[1]);
+            break;
+        default:
+            value = functions[instruction.index](fractions);
+    }
+
+    auto number = (long double) value;
+    long double error = fabsl(number) * Fraction::defaultMaxError;
+    return {number - error, number + error};
+}
+
+void CompiledExpression::EvalBatch(span<const double *const> columns, span<double> result) const {
+    const size_t blockSize = BatchKernels::blockSize;
+    // Каждый регистр хранит blockSize значений
+    vector<double> registers(numberOfRegisters * blockSize);
+    vector<Fraction> args;
+
+    if (columns.size() < variables.size())
+        throw runtime_error("Ошибка. Не задан столбец переменной " + variables[columns.size()]);
+
+    for (size_t begin = 0; begin < result.size(); begin += blockSize) {
+        size_t size = min(blockSize, result.size() - begin);
+
+        for (const auto &iter: instructions) {
+            const size_t *operand = operands.data() + iter.firstOperand;
+            double *target = registers.data() + iter.result * blockSize;
+
+            switch (iter.type) {
+                case constant:
+                    BatchKernels::Fill(target, doubleConstants[iter.index], size);
+                    continue;
+
+                case variable:
+                    copy(columns[iter.index] + begin, columns[iter.index] + begin + size, target);
+                    continue;
+
+                default:
+                    break;
+            }
+
+            if (iter.kernel != BatchKernels::generic) {
+                // Ядра работают на месте, поэтому первый операнд копируется в регистр результата
+                double *a = registers.data() + operand[0] * blockSize;
+                if (a != target) copy(a, a + size, target);
+
+                if (iter.type == binaryOperation)
+                    BatchKernels::Binary(iter.kernel, target, registers.data() + operand[1] * blockSize, size);
+                else BatchKernels::Unary(iter.kernel, target, size);
+                continue;
+            }
+
+            // Операции пользователя вычисляются поэлементно через Fraction
+            for (size_t i = 0; i < size; i++) {
+                try {
+                    args.clear();
+                    for (size_t j = 0; j < iter.numberOfArguments; j++)
+                        args.push_back(Fraction((long double) registers[operand[j] * blockSize + i]));
+
+                    Fraction value;
+                    if (iter.type == unaryOperation) value = unaryOperations[iter.index](args[0]);
+                    else if (iter.type == binaryOperation) value = binaryOperations[iter.index](args[0], args[1]);
+                    else value = functions[iter.index](args);
+
+                    target[i] = (double) (long double) value;
+                } catch (exception &error) {
+                    target[i] = numeric_limits<double>::quiet_NaN();
+                }
+            }
+        }
+
+        double *root = registers.data() + instructions.back().result * blockSize;
+        copy(root, root + size, result.begin() + (long) begin);
+    }
+}
+
+void CompiledExpression::EvalBatch(span<const double *const> columns, span<double> result, ThreadPool &pool) const {
+    const size_t blockSize = BatchKernels::blockSize;
+
+    if (columns.size() < variables.size())
+        throw runtime_error("Ошибка. Не задан столбец переменной " + variables[columns.size()]);
+
+    // Элемент работы пула - блок строк, так порции совпадают с блоками однопоточного вычисления
+    pool.ParallelFor((result.size() + blockSize - 1) / blockSize, [&](size_t begin, size_t end) {
+        size_t firstRow = begin * blockSize, lastRow = min(end * blockSize, result.size());
+        vector<const double *> part(columns.begin(), columns.end());
+
+        for (auto &iter: part) iter += firstRow;
+        EvalBatch(part, result.subspan(firstRow, lastRow - firstRow));
+    });
+}
+
+bool CompiledExpression::FoldInstruction(const Instruction &instruction) {
+    size_t numberOfArguments = instruction.numberOfArguments;
+    vector<Fraction> args;
+    vector<BigRational> exactArgs;
+    vector<Interval> intervalArgs;
+    Fraction value;
+    BigRational exactValue;
+    Interval intervalValue;
+
+    // Операнды, являющиеся константами, - это последние numberOfArguments инструкций
+    if (instructions.size() < numberOfArguments) return false;
+
+    for (size_t i = instructions.size() - numberOfArguments; i < instructions.size(); i++) {
+        if (instructions[i].type != constant) return false;
+        args.push_back(constants[instructions[i].index]);
+        exactArgs.push_back(exactConstants[instructions[i].index]);
+        intervalArgs.push_back(intervalConstants[instructions[i].index]);
+    }
+
+    try {
+        switch (instruction.type) {
+            case unaryOperation:
+                value = unaryOperations[instruction.index](args[0]);
+                break;
+            case binaryOperation:
+                value = binaryOperations[instruction.index](args[0], args[1]);
+                break;
+            case func:
+                value = functions[instruction.index](args);
+                break;
+            default:
+                return false;
+        }
+    } catch (exception &error) {
+        // Если в выражении есть длинные числа, Eval все равно выбрасывает исключение и значение Fraction не нужно
+        if (!hasLargeConstants) return false;
+    }
+
+    try {
+        exactValue = ApplyExact(instruction, exactArgs);
+    } catch (exception &error) {
+        return false;
+    }
+
+    // Интервал считается от интервалов операндов, а не от округленного значения Fraction
+    try {
+        intervalValue = ApplyInterval(instruction, intervalArgs);
+    } catch (exception &error) {
+        intervalValue = Interval::Entire();
+    }
+
+    instructions.resize(instructions.size() - numberOfArguments);
+    instructions.push_back({constant, constants.size(), 0, BatchKernels::generic, true, 0, 0});
+    constants.push_back(value);
+    exactConstants.push_back(exactValue);
+    intervalConstants.push_back(intervalValue);
+
+    return true;
+}
+
+// Назначает регистры живым вершинам графа, isLive[i] = false - вершина не вычисляется
+// Регистр освобождается после последнего использования значения, а результат по возможности
+// записывается на место первого операнда. Возвращает количество регистров
+static size_t AllocateRegisters(const vector<vector<size_t>> &nodeOperands, const vector<bool> &isLive, size_t root,
+                                vector<size_t> &registerOfNode) {
+    size_t numberOfNodes = nodeOperands.size();
+    size_t numberOfRegisters = 0;
+    // Номер последней вершины, использующей значение; корень используется до конца вычисления
+    vector<size_t> lastUse(numberOfNodes, numberOfNodes);
+    vector<size_t> freeRegisters;
+
+    for (size_t i = 0; i < numberOfNodes; i++)
+        if (isLive[i])
+            for (size_t argument: nodeOperands[i]) lastUse[argument] = i;
+    lastUse[root] = numberOfNodes;
+
+    registerOfNode.assign(numberOfNodes, 0);
+
+    for (size_t i = 0; i < numberOfNodes; i++) {
+        const vector<size_t> &arguments = nodeOperands[i];
+
+        if (!isLive[i]) continue;
+
+        // Если первый операнд больше не нужен, результат записывается на его место
+        if (!arguments.empty() && lastUse[arguments[0]] == i) registerOfNode[i] = registerOfNode[arguments[0]];
+        else if (!freeRegisters.empty()) {
+            registerOfNode[i] = freeRegisters.back();
+            freeRegisters.pop_back();
+        } else registerOfNode[i] = numberOfRegisters++;
+
+        // Освобождаем регистры остальных операндов, которые больше не используются
+        for (size_t argument: arguments) {
+            if (lastUse[argument] != i) continue;
+            if (registerOfNode[argument] != registerOfNode[i]) freeRegisters.push_back(registerOfNode[argument]);
+            lastUse[argument] = numberOfNodes;
+        }
+    }
+
+    return numberOfRegisters;
+}
+
+void CompiledExpression::BuildGraph() {
+    vector<Instruction> nodes;
+    // Операнды каждой вершины (номера вершин)
+    vector<vector<size_t>> nodeOperands;
+    // Словарь от описания чистой вершины (тип, операция или значение, операнды) к ее номеру
+    map<vector<long long>, size_t> nodeIndexes;
+    // Стек номеров вершин при обходе обратной польской нотации
+    vector<size_t> nodeStack;
+
+    for (const auto &iter: instructions) {
+        vector<size_t> arguments(nodeStack.end() - (long) iter.numberOfArguments, nodeStack.end());
+        nodeStack.resize(nodeStack.size() - iter.numberOfArguments);
+
+        vector<long long> key = {iter.type, (long long) iter.index};
+        // Одинаковые числа могут лежать в разных ячейках пула, поэтому константы сравниваются по значению
+        // Длинное число получает ключ с нулевым знаменателем и не совпадает ни с чем, кроме себя
+        if (iter.type == constant) {
+            const BigRational &value = exactConstants[iter.index];
+            if (value.IsSmall()) key = {iter.type, value.GetNumerator(), value.GetDenominator()};
+            else key = {iter.type, (long long) iter.index, 0};
+        }
+        for (size_t argument: arguments) key.push_back((long long) argument);
+
+        if (iter.isPure) {
+            auto found = nodeIndexes.find(key);
+            if (found != nodeIndexes.end()) {
+                nodeStack.push_back(found->second);
+                numberOfDeduplicatedNodes++;
+                continue;
+            }
+            nodeIndexes[key] = nodes.size();
+        }
+
+        nodeStack.push_back(nodes.size());
+        nodes.push_back(iter);
+        nodeOperands.push_back(arguments);
+    }
+
+    EmitInstructions(nodes, nodeOperands);
+    EmitCommands(nodes, nodeOperands);
+
+    doubleConstants.clear();
+    longDoubleConstants.clear();
+    for (const auto &iter: exactConstants) {
+        doubleConstants.push_back((double) iter);
+        longDoubleConstants.push_back((long double) iter);
+    }
+}
+
+void CompiledExpression::EmitInstructions(const vector<Instruction> &nodes,
+                                          const vector<vector<size_t>> &nodeOperands) {
+    vector<size_t> registerOfNode;
+
+    numberOfRegisters = AllocateRegisters(nodeOperands, vector<bool>(nodes.size(), true), nodes.size() - 1,
+                                          registerOfNode);
+
+    instructions.clear();
+    operands.clear();
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        instructions.push_back(nodes[i]);
+        instructions.back().firstOperand = operands.size();
+        instructions.back().result = registerOfNode[i];
+        for (size_t argument: nodeOperands[i]) operands.push_back(registerOfNode[argument]);
+    }
+}
+
+void CompiledExpression::EmitCommands(const vector<Instruction> &nodes, const vector<vector<size_t>> &nodeOperands) {
+    size_t numberOfNodes = nodes.size();
+    // Черновики команд: код, вершины-операнды и индекс константы, переменной или операции
+    vector<TypeOfCommands> codes(numberOfNodes);
+    vector<vector<size_t>> arguments(numberOfNodes);
+    vector<uint32_t> parameters(numberOfNodes, 0);
+    // alias - вершина, значение которой совпадает со значением данной (унарный плюс не порождает команду)
+    vector<size_t> alias(numberOfNodes);
+    vector<size_t> numberOfUses(numberOfNodes, 0);
+    vector<bool> isLive(numberOfNodes, true);
+
+    for (size_t i = 0; i < numberOfNodes; i++) {
+        alias[i] = i;
+        for (size_t argument: nodeOperands[i]) arguments[i].push_back(alias[argument]);
+
+        if (nodes[i].kernel == BatchKernels::plus) {
+            alias[i] = arguments[i][0];
+            isLive[i] = false;
+            continue;
+        }
+
+        for (size_t argument: arguments[i]) numberOfUses[argument]++;
+    }
+
+    size_t root = alias[numberOfNodes - 1];
+    // Количество использований констант, которые не удалось встроить в команды
+    vector<size_t> remainingUses = numberOfUses;
+
+    for (size_t i = 0; i < numberOfNodes; i++) {
+        const Instruction &node = nodes[i];
+        vector<size_t> &args = arguments[i];
+
+        if (!isLive[i]) continue;
+
+        parameters[i] = (uint32_t) node.index;
+
+        switch (node.type) {
+            case constant:
+                codes[i] = loadConstant;
+                continue;
+
+            case variable:
+                codes[i] = loadVariable;
+                continue;
+
+            case unaryOperation:
+                if (node.kernel != BatchKernels::negate) {
+                    codes[i] = callUnary;
+                    continue;
+                }
+
+                codes[i] = negate;
+                // -(a ^ b) вычисляется одной командой, если степень больше нигде не используется
+                if (isLive[args[0]] && numberOfUses[args[0]] == 1 &&
+                    (codes[args[0]] == power || codes[args[0]] == powerConstant)) {
+                    size_t base = args[0];
+                    codes[i] = (codes[base] == power ? negatePower : negatePowerConstant);
+                    parameters[i] = parameters[base];
+                    args = arguments[base];
+                    isLive[base] = false;
+                }
+                continue;
+
+            case func:
+                codes[i] = callFunction;
+                continue;
+
+            case binaryOperation:
+                break;
+        }
+
+        switch (node.kernel) {
+            case BatchKernels::add: codes[i] = add; break;
+            case BatchKernels::subtract: codes[i] = subtract; break;
+            case BatchKernels::multiply: codes[i] = multiply; break;
+            case BatchKernels::divide: codes[i] = divide; break;
+            case BatchKernels::power: codes[i] = power; break;
+            case BatchKernels::exponent: codes[i] = exponent; continue;
+            default: codes[i] = callBinary; continue;
+        }
+
+        size_t a = args[0], b = args[1];
+
+        // Правый операнд - константа: r = a op K
+        if (nodes[b].type == constant) {
+            codes[i] = (TypeOfCommands) (codes[i] - add + addConstant);
+            parameters[i] = (uint32_t) nodes[b].index;
+            args = {a};
+            remainingUses[b]--;
+        }
+            // Левый операнд - константа: для + и * операнды переставляются, для остальных есть команды K op a
+        else if (nodes[a].type == constant) {
+            TypeOfCommands code = codes[i];
+            if (code == add || code == multiply) codes[i] = (TypeOfCommands) (code - add + addConstant);
+            else codes[i] = (code == subtract ? constantSubtract : (code == divide ? constantDivide : constantPower));
+            parameters[i] = (uint32_t) nodes[a].index;
+            args = {b};
+            remainingUses[a]--;
+        }
+            // a * b + c вычисляется одной командой, если произведение больше нигде не используется
+        else if (codes[i] == add) {
+            size_t product = (codes[a] == multiply && numberOfUses[a] == 1 ? a : b);
+            size_t addend = (product == a ? b : a);
+
+            if (codes[product] == multiply && numberOfUses[product] == 1 && isLive[product]) {
+                codes[i] = multiplyAdd;
+                args = {arguments[product][0], arguments[product][1], addend};
+                isLive[product] = false;
+            }
+        }
+    }
+
+    // Константа не загружается в регистр, если все ее использования встроены в команды
+    for (size_t i = 0; i < numberOfNodes; i++)
+        if (isLive[i] && nodes[i].type == constant && remainingUses[i] == 0 && i != root) isLive[i] = false;
+
+    vector<size_t> registerOfNode;
+    numberOfCommandRegisters = AllocateRegisters(arguments, isLive, root, registerOfNode);
+
+    commands.clear();
+    commandOperands.clear();
+    maxNumberOfArguments = 0;
+
+    for (size_t i = 0; i < numberOfNodes; i++) {
+        if (!isLive[i]) continue;
+
+        Command command{codes[i], (uint32_t) registerOfNode[i], 0, 0, 0};
+        const vector<size_t> &args = arguments[i];
+
+        switch (codes[i]) {
+            case loadConstant:
+            case loadVariable:
+                command.a = parameters[i];
+                break;
+
+            case addConstant:
+            case subtractConstant:
+            case multiplyConstant:
+            case divideConstant:
+            case powerConstant:
+            case constantSubtract:
+            case constantDivide:
+            case constantPower:
+            case negatePowerConstant:
+            case callUnary:
+                command.a = (uint32_t) registerOfNode[args[0]];
+                command.b = parameters[i];
+                break;
+
+            case callFunction:
+                command.a = (uint32_t) commandOperands.size();
+                command.b = (uint32_t) args.size();
+                command.c = parameters[i];
+                maxNumberOfArguments = max(maxNumberOfArguments, args.size());
+                for (size_t argument: args) commandOperands.push_back((uint32_t) registerOfNode[argument]);
+                break;
+
+            default:
+                // Остальные команды берут операнды из регистров, callBinary - еще и индекс операции
+                for (size_t j = 0; j < args.size(); j++)
+                    (j == 0 ? command.a : (j == 1 ? command.b : command.c)) = (uint32_t) registerOfNode[args[j]];
+                if (codes[i] == callBinary) command.c = parameters[i];
+                break;
+        }
+
+        commands.push_back(command);
+    }
+
+    commands.push_back({stop, (uint32_t) registerOfNode[root], 0, 0, 0});
+}
+
+size_t CompiledExpression::GetNumberOfDeduplicatedNodes() const { return numberOfDeduplicatedNodes; }
+
+const vector<string> &CompiledExpression::GetVariables() const { return variables; }
+
+size_t CompiledExpression::GetVariableIndex(const string &name) const {
+    string lowerName = ToLowerName(name);
+
+    for (size_t i = 0; i < variables.size(); i++)
+        if (variables[i] == lowerName) return i;
+
+    throw runtime_error("Ошибка. Неизвестная переменная " + name);
+}
+
+string CompiledExpression::ToLowerName(const string &name) {
+    string lowerName = name;
+    for (char &symbol: lowerName)
+        if (symbol >= 'A' && symbol <= 'Z') symbol = (char) (symbol | 0x20);
+
+    return lowerName;
+}
+
+// Поиск методом ветвей и границ: очередь подобластей упорядочена по нижней оценке выражения,
+// лучшая найденная точка дает верхнюю оценку минимума, а подобласти с нижней оценкой выше нее отбрасываются
+// Максимум ищется как минимум выражения со знаком минус
+static CompiledExpression::Extremum FindExtremum(const CompiledExpression &expression, span<const Interval> box,
+                                                 long double tolerance, size_t maxNumberOfBoxes, bool isMaximum) {
+    const vector<string> &variables = expression.GetVariables();
+
+    struct Box {
+        long double lowerBound;
+        vector<Interval> values;
+
+        // Вершина priority_queue - подобласть с наименьшей нижней оценкой
+        bool operator<(const Box &other) const { return lowerBound > other.lowerBound; }
+    };
+
+    priority_queue<Box> boxes;
+    CompiledExpression::Extremum result{Interval::Empty(), {}, 0};
+    long double upperBound = numeric_limits<long double>::infinity();
+
+    if (box.size() < variables.size()) throw runtime_error("Ошибка. Не задано значение переменной " + variables[box.size()]);
+    for (const auto &iter: box)
+        if (iter.IsEmpty() || !isfinite(iter.GetLower()) || !isfinite(iter.GetUpper()))
+            throw runtime_error("Ошибка. Область поиска должна быть ограниченной");
+
+    auto evaluate = [&](const vector<Interval> &values) {
+        Interval value = expression.EvalAs<Interval>(values);
+        return (isMaximum ? -value : value);
+    };
+
+    // Подобласть без значений или с оценкой хуже лучшей точки отбрасывается, иначе ее середина уточняет лучшую точку
+    auto consider = [&](vector<Interval> values) {
+        result.numberOfBoxes++;
+
+        Interval value = evaluate(values);
+        if (value.IsEmpty() || value.GetLower() > upperBound) return;
+
+        vector<Interval> middle;
+        for (const auto &iter: values) middle.emplace_back(iter.GetMiddle());
+
+        try {
+            Interval middleValue = evaluate(middle);
+            if (!middleValue.IsEmpty() && middleValue.GetUpper() < upperBound) {
+                upperBound = middleValue.GetUpper();
+                result.point.clear();
+                for (const auto &iter: middle) result.point.push_back(iter.GetLower());
+            }
+        } catch (runtime_error &error) {
+            // Операция пользователя может быть не определена в середине, тогда точка просто не уточняется
+        }
+
+        boxes.push({value.GetLower(), std::move(values)});
+    };
+
+    consider(vector<Interval>(box.begin(), box.end()));
+
+    while (true) {
+        // Подобласть с лучшей точкой не отбрасывается, поэтому очередь пустеет, только если такой точки нет
+        if (boxes.empty()) throw runtime_error("Ошибка вычисления. Выражение не определено в области поиска");
+
+        Box current = boxes.top();
+        boxes.pop();
+
+        size_t widest = 0;
+        for (size_t i = 1; i < current.values.size(); i++)
+            if (current.values[i].GetWidth() > current.values[widest].GetWidth()) widest = i;
+
+        // Подобласть из одной точки или слишком узкая для long double делиться не может
+        long double middle = 0;
+        bool canDivide = !current.values.empty();
+        if (canDivide) {
+            middle = current.values[widest].GetMiddle();
+            canDivide = (current.values[widest].GetLower() < middle && middle < current.values[widest].GetUpper());
+        }
+
+        // Наименьшая нижняя оценка в очереди - нижняя оценка минимума во всей области
+        if (upperBound - current.lowerBound <= tolerance || result.numberOfBoxes >= maxNumberOfBoxes || !canDivide) {
+            result.value = {current.lowerBound, max(current.lowerBound, upperBound)};
+            break;
+        }
+
+        vector<Interval> left = current.values, right = current.values;
+        left[widest] = {current.values[widest].GetLower(), middle};
+        right[widest] = {middle, current.values[widest].GetUpper()};
+        consider(std::move(left));
+        consider(std::move(right));
+    }
+
+    if (isMaximum) result.value = -result.value;
+
+    return result;
+}
+
+CompiledExpression::Extremum CompiledExpression::FindMinimum(span<const Interval> box, long double tolerance,
+                                                             size_t maxNumberOfBoxes) const {
+    return FindExtremum(*this, box, tolerance, maxNumberOfBoxes, false);
+}
+
+CompiledExpression::Extremum CompiledExpression::FindMaximum(span<const Interval> box, long double tolerance,
+                                                             size_t maxNumberOfBoxes) const {
+    return FindExtremum(*this, box, tolerance, maxNumberOfBoxes, true);
+}
@@ -0,0 +1,8 @@
+#include "../include/EvaluationArena.hpp"
+
+void EvaluationArena::Reserve(size_t numberOfRegisters, size_t numberOfArguments) {
+    if (registers.size() < numberOfRegisters) registers.resize(numberOfRegisters);
+    if (args.capacity() < numberOfArguments) args.reserve(numberOfArguments);
+}
+
+bool EvaluationArena::IsBusy() const { return isBusy; }
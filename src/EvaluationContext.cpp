@@ -0,0 +1,25 @@
+#include "../include/EvaluationContext.hpp"
+
+EvaluationContext::EvaluationContext() : operations(Operations::GetInstance().GetSnapshot()) {}
+
+void EvaluationContext::AddBinaryOperation(const string &name,
+                                           const function<Fraction(const Fraction &, const Fraction &)> &func,
+                                           int priority, bool isPure) {
+    operations.AddBinaryOperation(name, func, priority, isPure);
+}
+
+void EvaluationContext::AddUnaryOperation(const string &name, const function<Fraction(const Fraction &)> &func,
+                                          int priority, bool isPure) {
+    operations.AddUnaryOperation(name, func, priority, isPure);
+}
+
+void EvaluationContext::AddFunction(const string &name, const function<Fraction(const vector<Fraction> &)> &func,
+                                    int priority, int numberOfArguments, bool isPure) {
+    operations.AddFunction(name, func, priority, numberOfArguments, isPure);
+}
+
+bool EvaluationContext::IsBinaryOperation(const string &name) { return operations.IsBinaryOperation(name); }
+
+bool EvaluationContext::IsUnaryOperation(const string &name) { return operations.IsUnaryOperation(name); }
+
+bool EvaluationContext::IsFunction(const string &name) { return operations.IsFunction(name); }
@@ -0,0 +1,103 @@
+#include "../include/ExpressionCache.hpp"
+#include "../include/MathParser.hpp"
+
+// Символ является частью слова или числа, пробел рядом с ним может разделять токены
+static bool IsWordSymbol(char symbol) { return isalnum((unsigned char) symbol) || symbol == '.' || symbol == '_'; }
+
+ExpressionCache::ExpressionCache(size_t capacity, size_t numberOfShards) : shards(max<size_t>(numberOfShards, 1)) {
+    if (capacity == 0) throw runtime_error("Ошибка. Размер кэша должен быть положительным");
+
+    capacityOfShard = max<size_t>(capacity / shards.size(), 1);
+}
+
+shared_ptr<const CompiledExpression> ExpressionCache::Get(const string &expression) {
+    string key = Normalize(expression);
+    Shard &shard = shards[hash<string>()(key) % shards.size()];
+    // Номер берется до компиляции: если реестр изменится во время нее, запись просто скомпилируется еще раз
+    size_t version = Operations::GetInstance().GetSnapshot()->GetVersion();
+
+    {
+        lock_guard<mutex> guard(shard.lock);
+
+        auto iter = shard.entries.find(key);
+        if (iter != shard.entries.end() && iter->second->version == version) {
+            // Переносим запись в начало списка как недавно использованную
+            shard.order.splice(shard.order.begin(), shard.order, iter->second);
+            hits++;
+            return iter->second->compiled;
+        }
+    }
+
+    misses++;
+
+    // Компилируем без блокировки, чтобы не задерживать другие потоки этого сегмента
+    auto compiled = make_shared<const CompiledExpression>(MathExpression(key).Compile());
+
+    lock_guard<mutex> guard(shard.lock);
+
+    auto iter = shard.entries.find(key);
+    if (iter != shard.entries.end()) {
+        // Пока шла компиляция, то же выражение мог добавить другой поток, иначе обновляем устаревшую запись
+        if (iter->second->version >= version) return iter->second->compiled;
+
+        iter->second->version = version;
+        iter->second->compiled = compiled;
+        shard.order.splice(shard.order.begin(), shard.order, iter->second);
+        return compiled;
+    }
+
+    shard.order.push_front({key, version, compiled});
+    shard.entries[key] = shard.order.begin();
+
+    if (shard.order.size() > capacityOfShard) {
+        shard.entries.erase(shard.order.back().key);
+        shard.order.pop_back();
+        evictions++;
+    }
+
+    return compiled;
+}
+
+void ExpressionCache::Clear() {
+    for (auto &shard: shards) {
+        lock_guard<mutex> guard(shard.lock);
+        shard.order.clear();
+        shard.entries.clear();
+    }
+}
+
+size_t ExpressionCache::GetSize() {
+    size_t size = 0;
+
+    for (auto &shard: shards) {
+        lock_guard<mutex> guard(shard.lock);
+        size += shard.order.size();
+    }
+
+    return size;
+}
+
+size_t ExpressionCache::GetHits() const { return hits; }
+
+size_t ExpressionCache::GetMisses() const { return misses; }
+
+size_t ExpressionCache::GetEvictions() const { return evictions; }
+
+string ExpressionCache::Normalize(const string &expression) {
+    string result;
+    bool isSpace = false;
+
+    for (char symbol: expression) {
+        if (isspace((unsigned char) symbol)) {
+            isSpace = true;
+            continue;
+        }
+
+        // Пробел между двумя частями слов или чисел сохраняется, иначе они бы слились в один токен
+        if (isSpace && !result.empty() && IsWordSymbol(result.back()) && IsWordSymbol(symbol)) result += ' ';
+        result += symbol;
+        isSpace = false;
+    }
+
+    return result;
+}
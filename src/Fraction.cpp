@@ -1,11 +1,175 @@
 #include "../include/Fraction.hpp"
 
-long long Fraction::GCD(long long a, long long b) {
-    while (b) {
+unsigned long long Fraction::GCD(unsigned long long a, unsigned long long b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+
+    // Общие множители 2 выносятся сразу, дальше из разности двух нечетных чисел убираются ее множители 2
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+
+    while (b != 0) {
+        b >>= __builtin_ctzll(b);
+        if (a > b) swap(a, b);
+        b -= a;
+    }
+
+    return a << shift;
+}
+
+// Количество младших нулевых битов ненулевого 128-битного числа
+static int CountTrailingZeros(unsigned __int128 a) {
+    auto low = (unsigned long long) a;
+    return (low != 0 ? __builtin_ctzll(low) : 64 + __builtin_ctzll((unsigned long long) (a >> 64)));
+}
+
+unsigned __int128 Fraction::GCD(unsigned __int128 a, unsigned __int128 b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+
+    int shift = CountTrailingZeros(a | b);
+    a >>= CountTrailingZeros(a);
+
+    while (b != 0) {
+        b >>= CountTrailingZeros(b);
+        if (a > b) swap(a, b);
+        b -= a;
+
+        // Когда оба числа помещаются в 64 бита, продолжаем более быстрой версией
+        if ((a >> 64) == 0 && (b >> 64) == 0)
+            return (unsigned __int128) GCD((unsigned long long) a, (unsigned long long) b) << shift;
+    }
+
+    return a << shift;
+}
+
+// Число помещается в long long
+static bool IsLongLong(__int128 a) {
+    return (a >= numeric_limits<long long>::min() && a <= numeric_limits<long long>::max());
+}
+
+// Возводит base в степень exponent возведением в квадрат, false - если результат не помещается в long long
+static bool IntegerPower(long long base, unsigned long long exponent, long long &result) {
+    result = 1;
+
+    while (exponent != 0) {
+        if ((exponent & 1) && __builtin_mul_overflow(result, base, &result)) return false;
+        exponent >>= 1;
+        // Квадрат нужен, только если остались биты показателя, иначе его переполнение ничего не значит
+        if (exponent != 0 && __builtin_mul_overflow(base, base, &base)) return false;
+    }
+
+    return true;
+}
+
+// Извлекает из неотрицательного a целый корень степени degree, false - если корень не целый
+static bool IntegerRoot(long long a, unsigned long long degree, long long &root) {
+    if (a <= 1 || degree == 1) {
+        root = a;
+        return true;
+    }
+    // 2^64 уже не помещается в long long
+    if (degree >= 64) return false;
+
+    // Корень в long double может ошибиться на единицу, поэтому проверяются соседние числа
+    // Квадратный и кубический корни встречаются чаще всего и считаются быстрее powl
+    long double approximateRoot = (degree == 2 ? sqrtl((long double) a) : degree == 3 ? cbrtl((long double) a)
+                                                                             : powl((long double) a, 1 / (long double) degree));
+    auto guess = (long long) llroundl(approximateRoot);
+    long long power;
+    for (long long candidate = max(guess - 1, 1LL); candidate <= guess + 1; candidate++)
+        if (IntegerPower(candidate, degree, power) && power == a) {
+            root = candidate;
+            return true;
+        }
+
+    return false;
+}
+
+Fraction Fraction::Make(__int128 numerator, __int128 denominator) {
+    Fraction result;
+
+    if (denominator < 0) {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+
+    if (!IsLongLong(numerator) || !IsLongLong(denominator)) {
+        auto gcd = (__int128) GCD((unsigned __int128) (numerator < 0 ? -numerator : numerator),
+                                  (unsigned __int128) denominator);
+        numerator /= gcd;
+        denominator /= gcd;
+
+        // Точная дробь не помещается в long long: заменяем ее ближайшей, ноль вместо ненулевой дроби - ошибка
+        if (!IsLongLong(numerator) || !IsLongLong(denominator)) {
+            result = Round(numerator, denominator);
+            if (result.numerator == 0) throw runtime_error("Ошибка. Слишком маленькое число");
+            return result;
+        }
+    }
+
+    result.numerator = (long long) numerator;
+    result.denominator = (long long) denominator;
+    return result;
+}
+
+// Возвращает true, если a / b меньше c / d, b и d больше нуля; сравнивает цепные дроби без переполнения
+static bool IsLess(unsigned __int128 a, unsigned __int128 b, unsigned __int128 c, unsigned __int128 d) {
+    bool isInverted = false;
+
+    for (;;) {
+        if (a / b != c / d) return (a / b < c / d) != isInverted;
+
+        // Целые части равны, сравниваем дробные части, а через них - обратные к ним числа
         a %= b;
+        c %= d;
+        if (a == 0 && c == 0) return false;
+        if (a == 0 || c == 0) return (a == 0) != isInverted;
+
         swap(a, b);
+        swap(c, d);
+        isInverted = !isInverted;
     }
-    return abs(a);
+}
+
+Fraction Fraction::Round(__int128 numerator, __int128 denominator) {
+    const auto limit = (unsigned __int128) numeric_limits<long long>::max();
+    auto a = (unsigned __int128) (numerator < 0 ? -numerator : numerator), b = (unsigned __int128) denominator;
+    // Две последние подходящие дроби цепной дроби a / b: p0/q0 и p1/q1
+    unsigned __int128 p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+
+    while (b != 0) {
+        unsigned __int128 element = a / b, rest = a % b;
+        // Наибольший шаг, при котором числитель и знаменатель следующей дроби не больше limit
+        unsigned __int128 step = min((p1 == 0 ? element : (limit - p0) / p1),
+                                     (q1 == 0 ? element : (limit - q0) / q1));
+
+        if (step < element) {
+            // Целая часть не помещается в long long
+            if (q1 == 0) throw runtime_error("Ошибка. Слишком большое число");
+
+            // Остаток цепной дроби равен element + rest / b, промежуточная дробь ближе последней подходящей,
+            // если он меньше 2 * step + q0 / q1
+            if (2 * step > element || (2 * step == element && IsLess(rest, b, q0, q1))) {
+                p1 = step * p1 + p0;
+                q1 = step * q1 + q0;
+            }
+            break;
+        }
+
+        unsigned __int128 p2 = element * p1 + p0, q2 = element * q1 + q0;
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
+        a = b;
+        b = rest;
+    }
+
+    Fraction result;
+    result.numerator = (numerator < 0 ? -(long long) p1 : (long long) p1);
+    result.denominator = (long long) q1;
+    return result;
 }
 
 Fraction::Fraction() {
@@ -13,65 +177,85 @@ Fraction::Fraction() {
     denominator = 1;
 }
 
-Fraction::Fraction(const long double &number) {
+Fraction::Fraction(const long double &number) : Fraction(number, defaultMaxError, defaultMaxDenominator) {}
+
+Fraction::Fraction(const long double &number, long double maxError, long long maxDenominator) {
     // Если number равно nan или inf
     if (!isfinite(number))
         throw runtime_error("Ошибка вычисления. Проверьте выражение");
 
-    // Если number превышает максимум типа long long
-    if (number > numeric_limits<long long>::max())
+    // Если number выходит за пределы типа long long
+    if (number >= (long double) numeric_limits<long long>::max() || number <= (long double) numeric_limits<long long>::min())
         throw runtime_error("Ошибка. Слишком большое число");
 
-    long long integral = (long long) number; // целая часть числа
-    long double decimal = number - integral; // дробная часть числа
+    const long long maxNumerator = numeric_limits<long long>::max();
+    long double x = fabsl(number), rest = x, tolerance = maxError * x;
+    // Две последние подходящие дроби цепной дроби x: previous = p0/q0, current = p1/q1
+    long long p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+
+    // Спуск по дереву Штерна - Броко целыми шагами: каждый шаг - следующий элемент цепной дроби
+    for (;;) {
+        // Элемент больше любого допустимого знаменателя, поэтому следующая подходящая дробь точно не подходит
+        long long element = (rest < (long double) maxNumerator ? (long long) rest : maxNumerator);
+        long long p2, q2;
+
+        if (__builtin_mul_overflow(element, p1, &p2) || __builtin_add_overflow(p2, p0, &p2) ||
+            __builtin_mul_overflow(element, q1, &q2) || __builtin_add_overflow(q2, q0, &q2) || q2 > maxDenominator) {
+            // Промежуточная дробь с наибольшим допустимым шагом может оказаться ближе последней подходящей
+            long long step = (maxDenominator - q0) / max(q1, 1LL);
+            if (p1 != 0) step = min(step, (maxNumerator - p0) / p1);
+
+            long long p = step * p1 + p0, q = step * q1 + q0;
+            if (q1 == 0 || (step > 0 && fabsl(x * q - p) * q1 < fabsl(x * q1 - p1) * q)) {
+                p1 = p;
+                q1 = q;
+            }
+            break;
+        }
 
-    // Округляем дробную часть числа до точности precision
-    // Изначально является числителем без учета целой части
-    long long roundedDecimal = (long long) round(decimal * precision);
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
 
-    // Находим наибольший общий делитель числителя и знаменателя
-    long long gcd = GCD(roundedDecimal, precision);
+        // |x - p1/q1| <= tolerance без деления
+        long double decimal = rest - (long double) element;
+        if (decimal == 0 || fabsl(x * q1 - p1) <= tolerance * q1) break;
+        rest = 1 / decimal;
+    }
 
-    // Сокращаем знаменатель насколько возможно
-    denominator = precision / gcd;
-    // Сокращаем числитель насколько возможно и прибавляем оставшуюся целую часть
-    numerator = roundedDecimal / gcd + integral * denominator;
+    numerator = (number < 0 ? -p1 : p1);
+    denominator = max(q1, 1LL);
 }
 
 Fraction::Fraction(const string &str) {
-    size_t index = str.find('.');
-    try {
-        // Если точка есть
-        if (index != string::npos) {
-            // Получаем целую часть числа (находится до точки)
-            string integral = str.substr(0, index);
-            if (integral.empty()) integral = "0";
-            // Получаем дробную часть числа (находится после точки)
-            string decimal = str.substr(index + 1, log10(precision));
-            if (decimal.empty()) decimal = "0";
-            // Получаем числитель
-            numerator = stoll(decimal);
-            // Получаем знаменатель
-            denominator = (long long) pow(10, decimal.size());
-
-            // Находим наибольший общий делитель числителя и знаменателя
-            long long gcd = GCD(numerator, denominator);
-            // Сокращаем знаменатель насколько возможно
-            numerator /= gcd;
-            // Сокращаем числитель насколько возможно
-            denominator /= gcd;
-
-            // Прибавляем оставшуюся целую часть
-            numerator += stoll(integral) * denominator;
-            // Если точки нет, то есть переданное число является целым
-        } else {
-            // Получаем числитель
-            numerator = stoll(str);
-            denominator = 1;
-        }
-    } catch (out_of_range &error) {
-        throw runtime_error("Ошибка. Слишком большое число");
+    Decimal decimal = ScanDecimal(str);
+    if (!decimal.isValid || decimal.length != str.size()) throw runtime_error("Ошибка. Некорректное число " + str);
+
+    *this = FromDecimal(decimal);
+}
+
+Fraction Fraction::FromDecimal(const Decimal &decimal) {
+    auto mantissa = (long long) decimal.mantissa;
+
+    if (mantissa == 0) return Fraction();
+
+    // Целое число: умножаем на степень 10, пока нет переполнения
+    if (decimal.exponent >= 0) {
+        for (long long i = 0; i < decimal.exponent; i++)
+            if (__builtin_mul_overflow(mantissa, 10LL, &mantissa)) throw runtime_error("Ошибка. Слишком большое число");
+        return Make(mantissa, 1);
     }
+
+    // Знаменатель до 10^38 помещается в __int128, Round сокращает дробь и при необходимости округляет ее,
+    // слишком малое число округляется до нуля
+    if (decimal.exponent >= -38) {
+        __int128 denominator = 1;
+        for (long long i = 0; i < -decimal.exponent; i++) denominator *= 10;
+        return Round(mantissa, denominator);
+    }
+
+    return Fraction((long double) mantissa * powl(10.0L, (long double) decimal.exponent));
 }
 
 
@@ -97,65 +281,57 @@ long double Fraction::ConvertFractionToDouble() const { return (long double) num
 Fraction::operator long double() const { return ConvertFractionToDouble(); }
 
 Fraction Fraction::operator+(const Fraction &fraction) const {
-    Fraction result;
-
-    // Правило сложения дробей по правилам математики
-    if (denominator == fraction.GetDenominator()) {
-        result.SetNumerator(numerator + fraction.GetNumerator());
-        result.SetDenominator(denominator);
-    } else {
-        result.SetNumerator(numerator * fraction.GetDenominator() + denominator * fraction.GetNumerator());
-        result.SetDenominator(denominator * fraction.GetDenominator());
-    }
-
-    return result;
+    long long a, b, sum, product;
+
+    // Правило сложения дробей по правилам математики, пока нет переполнения - в long long
+    if (denominator == fraction.denominator && !__builtin_add_overflow(numerator, fraction.numerator, &sum))
+        return Make(sum, denominator);
+    if (!__builtin_mul_overflow(numerator, fraction.denominator, &a) &&
+        !__builtin_mul_overflow(denominator, fraction.numerator, &b) && !__builtin_add_overflow(a, b, &sum) &&
+        !__builtin_mul_overflow(denominator, fraction.denominator, &product))
+        return Make(sum, product);
+
+    return Make((__int128) numerator * fraction.denominator + (__int128) denominator * fraction.numerator,
+                (__int128) denominator * fraction.denominator);
 }
 
 Fraction Fraction::operator-(const Fraction &fraction) const {
-    Fraction result;
-
-    // Правило вычитания дробей по правилам математики
-    if (denominator == fraction.GetDenominator()) {
-        result.SetNumerator(numerator - fraction.GetNumerator());
-        result.SetDenominator(denominator);
-    } else {
-        result.SetNumerator(numerator * fraction.GetDenominator() - denominator * fraction.GetNumerator());
-        result.SetDenominator(denominator * fraction.GetDenominator());
-    }
-
-    return result;
+    long long a, b, difference, product;
+
+    // Правило вычитания дробей по правилам математики, пока нет переполнения - в long long
+    if (denominator == fraction.denominator &&
+        !__builtin_sub_overflow(numerator, fraction.numerator, &difference))
+        return Make(difference, denominator);
+    if (!__builtin_mul_overflow(numerator, fraction.denominator, &a) &&
+        !__builtin_mul_overflow(denominator, fraction.numerator, &b) && !__builtin_sub_overflow(a, b, &difference) &&
+        !__builtin_mul_overflow(denominator, fraction.denominator, &product))
+        return Make(difference, product);
+
+    return Make((__int128) numerator * fraction.denominator - (__int128) denominator * fraction.numerator,
+                (__int128) denominator * fraction.denominator);
 }
 
 Fraction Fraction::operator-() const {
-    Fraction result;
-
     // Получаем дробь, противоположную по знаку
-    result.SetNumerator(-numerator);
-    result.SetDenominator(denominator);
-
-    return result;
+    return Make(-(__int128) numerator, denominator);
 }
 
 Fraction Fraction::operator*(const Fraction &fraction) const {
-    Fraction result;
+    long long a, b;
 
-    // Правило умножения дробей по правилам математики
-    result.SetNumerator(numerator * fraction.GetNumerator());
-    result.SetDenominator(denominator * fraction.GetDenominator());
+    // Правило умножения дробей по правилам математики, пока нет переполнения - в long long
+    if (!__builtin_mul_overflow(numerator, fraction.numerator, &a) &&
+        !__builtin_mul_overflow(denominator, fraction.denominator, &b))
+        return Make(a, b);
 
-    return result;
+    return Make((__int128) numerator * fraction.numerator, (__int128) denominator * fraction.denominator);
 }
 
 Fraction Fraction::operator/(const Fraction &fraction) const {
-    Fraction result;
+    if (fraction.numerator == 0) throw runtime_error("Ошибка вычисления. Деление на ноль");
 
     // Правило деления дробей по правилам математики
-    result.SetNumerator(numerator * fraction.GetDenominator());
-    result.SetDenominator(denominator * fraction.GetNumerator());
-
-    if (!isfinite((long double) result)) throw runtime_error("Ошибка вычисления. Деление на ноль");
-
-    return result;
+    return Make((__int128) numerator * fraction.denominator, (__int128) denominator * fraction.numerator);
 }
 
 Fraction &Fraction::operator=(const Fraction &fraction) {
@@ -166,49 +342,69 @@ Fraction &Fraction::operator=(const Fraction &fraction) {
     return *this;
 }
 
+// Произведения числителей на знаменатели помещаются в __int128, поэтому сравнение точное
 bool Fraction::operator<(const Fraction &fraction) const {
-    return (numerator * fraction.GetDenominator()) < (fraction.GetNumerator() * denominator);
+    return (__int128) numerator * fraction.denominator < (__int128) fraction.numerator * denominator;
 }
 
 bool Fraction::operator<=(const Fraction &fraction) const {
-    return (numerator * fraction.GetDenominator()) <= (fraction.GetNumerator() * denominator);
+    return (__int128) numerator * fraction.denominator <= (__int128) fraction.numerator * denominator;
 }
 
 bool Fraction::operator>(const Fraction &fraction) const {
-    return (numerator * fraction.GetDenominator()) > (fraction.GetNumerator() * denominator);
+    return (__int128) numerator * fraction.denominator > (__int128) fraction.numerator * denominator;
 }
 
 bool Fraction::operator>=(const Fraction &fraction) const {
-    return (numerator * fraction.GetDenominator()) >= (fraction.GetNumerator() * denominator);
+    return (__int128) numerator * fraction.denominator >= (__int128) fraction.numerator * denominator;
 }
 
 bool Fraction::operator==(const Fraction &fraction) const {
-    return (numerator * fraction.GetDenominator()) == (fraction.GetNumerator() * denominator);
+    return (__int128) numerator * fraction.denominator == (__int128) fraction.numerator * denominator;
 }
 
 bool Fraction::operator!=(const Fraction &fraction) const {
-    return (numerator * fraction.GetDenominator()) != (fraction.GetNumerator() * denominator);
+    return (__int128) numerator * fraction.denominator != (__int128) fraction.numerator * denominator;
 }
 
 Fraction Fraction::Power(const Fraction &a, const Fraction &b) {
-    bool isBaseNegative = false;
-    long double base = a.ConvertFractionToDouble();
-
-    // Если основание степени отрицательное
-    if (base < 0) {
-        isBaseNegative = true;
-        base = abs(base);
-    }
+    bool isBaseNegative = (a.numerator < 0);
 
+    // Показатель может быть не сокращен, а четность числителя и знаменателя имеет смысл только у несократимой дроби
     long long exponentNumerator = b.GetNumerator();
     long long exponentDenominator = b.GetDenominator();
+    auto gcd = (long long) GCD((unsigned long long) llabs(exponentNumerator), (unsigned long long) exponentDenominator);
+    exponentNumerator /= gcd;
+    exponentDenominator /= gcd;
 
     if (isBaseNegative && !IsEven(exponentNumerator) && IsEven(exponentDenominator))
         throw runtime_error("Ошибка вычисления. Извлечение четного корня из отрицательного числа");
 
-    // Возводим основание в дробную степень, где числитель - возведение в степень, а знаменатель - извлечение корня
-    Fraction result(pow(pow(base, 1 / (long double) exponentDenominator), exponentNumerator));
+    // Основание тоже сокращается, иначе корень из числителя и знаменателя может не найтись
+    unsigned long long baseNumerator = (isBaseNegative ? 0 - (unsigned long long) a.numerator : a.numerator);
+    unsigned long long baseGCD = GCD(baseNumerator, (unsigned long long) a.denominator);
+    baseNumerator /= baseGCD;
+    auto baseDenominator = (long long) ((unsigned long long) a.denominator / baseGCD);
+    auto exponent = (unsigned long long) llabs(exponentNumerator);
+    long long rootNumerator, rootDenominator, numerator, denominator;
+
+    // Если корень из основания целый, степень вычисляется точно возведением в квадрат
+    if (baseNumerator <= (unsigned long long) numeric_limits<long long>::max() &&
+        IntegerRoot((long long) baseNumerator, exponentDenominator, rootNumerator) &&
+        IntegerRoot(baseDenominator, exponentDenominator, rootDenominator) &&
+        IntegerPower(rootNumerator, exponent, numerator) && IntegerPower(rootDenominator, exponent, denominator)) {
+        if (exponentNumerator < 0) {
+            if (numerator == 0) throw runtime_error("Ошибка вычисления. Деление на ноль");
+            swap(numerator, denominator);
+        }
+        // Нечетная степень отрицательного основания сохраняет минус
+        if (isBaseNegative && !IsEven(exponentNumerator)) numerator = -numerator;
+        return Make(numerator, denominator);
+    }
 
+    // Иначе возводим основание в дробную степень, где числитель - возведение в степень, а знаменатель - извлечение корня
+    long double base = fabsl(a.ConvertFractionToDouble());
+    Fraction result(pow(pow(base, 1 / (long double) exponentDenominator), exponentNumerator));
 
     // Если основание степени отрицательное и оно возводится в нечетную степень, то сохраняем минус
     if (isBaseNegative && !IsEven(exponentNumerator)) result.SetNumerator(-result.GetNumerator());
@@ -0,0 +1,295 @@
+#include "../include/Interval.hpp"
+
+#include <algorithm>
+
+// Погрешность в единицах последнего разряда: арифметика и sqrt округляются к ближайшему (полразряда),
+// функции long double из libm ошибаются не больше чем на пару разрядов
+static const int arithmeticError = 1;
+static const int functionError = 4;
+
+static const long double pi = 3.141592653589793238462643383279502884L;
+static const long double halfPi = pi / 2;
+static const long double twoPi = pi * 2;
+
+static const long double infinity = numeric_limits<long double>::infinity();
+
+// Произведение, в котором 0 * inf = 0: значения интервала конечны, бесконечная граница - лишь оценка
+static long double Product(long double a, long double b) { return (a == 0 || b == 0 ? 0 : a * b); }
+
+// Есть ли на [from, to] точка offset + k * period с целым k
+// Граница проверки расширена, чтобы погрешность числа pi не потеряла точку: лишняя точка лишь расширяет ответ
+static bool ContainsPeriodPoint(long double from, long double to, long double offset, long double period) {
+    long double first = (from - offset) / period, last = (to - offset) / period;
+    long double slack = 1e-15L * (1 + max(fabsl(first), fabsl(last)));
+
+    return ceill(first - slack) <= floorl(last + slack);
+}
+
+// arcctg без вычитания близких чисел: при x > 0 это arctg(1 / x)
+static long double Arccotangent(long double x) { return (x > 0 ? atanl(1 / x) : halfPi - atanl(x)); }
+
+// Ищет дробь p/q, равную показателю b, по тем же правилам, что BatchKernels::Power, целый показатель дает q = 1
+static bool FindExponentFraction(long double b, long long &p, long long &q) {
+    const long long maxDenominator = 1000;
+    // Наибольший по модулю показатель, который обрабатывается как дробь
+    const long double maxExponent = 4611686018427387904.0L;
+
+    if (!(fabsl(b) < maxExponent)) return false;
+
+    for (q = 1; q <= maxDenominator; q++) {
+        long double numerator = roundl(b * (long double) q);
+        if (fabsl(b * (long double) q - numerator) > 1e-9L * (long double) q) continue;
+
+        p = (long long) numerator;
+        return true;
+    }
+
+    return false;
+}
+
+Interval::Interval(long double lower, long double upper) : lower(lower), upper(upper) {
+    if (!(lower <= upper)) throw runtime_error("Ошибка. Нижняя граница интервала больше верхней");
+}
+
+Interval::Interval(const BigRational &value) {
+    auto number = (long double) value;
+
+    // Короткое целое число помещается в long double точно, короткая дробь округляется одним делением
+    if (value.IsSmall() && value.IsInteger()) lower = upper = number;
+    else *this = Outward(number, number, (value.IsSmall() ? arithmeticError : functionError));
+}
+
+Interval Interval::Empty() {
+    Interval result;
+    result.lower = infinity;
+    result.upper = -infinity;
+    return result;
+}
+
+Interval Interval::Entire() { return {-infinity, infinity}; }
+
+Interval Interval::Outward(long double lower, long double upper, int numberOfUlps) {
+    if (isnan(lower) || isnan(upper)) return Entire();
+
+    for (int i = 0; i < numberOfUlps; i++) {
+        lower = nextafterl(lower, -infinity);
+        upper = nextafterl(upper, infinity);
+    }
+
+    return {lower, upper};
+}
+
+long double Interval::GetLower() const { return lower; }
+
+long double Interval::GetUpper() const { return upper; }
+
+bool Interval::IsEmpty() const { return lower > upper; }
+
+bool Interval::IsPoint() const { return lower == upper; }
+
+long double Interval::GetWidth() const { return upper - lower; }
+
+long double Interval::GetMiddle() const { return lower / 2 + upper / 2; }
+
+bool Interval::Contains(long double value) const { return lower <= value && value <= upper; }
+
+Interval Interval::operator+(const Interval &other) const {
+    if (IsEmpty() || other.IsEmpty()) return Empty();
+    return Outward(lower + other.lower, upper + other.upper, arithmeticError);
+}
+
+Interval Interval::operator-(const Interval &other) const {
+    if (IsEmpty() || other.IsEmpty()) return Empty();
+    return Outward(lower - other.upper, upper - other.lower, arithmeticError);
+}
+
+Interval Interval::operator-() const {
+    Interval result;
+    result.lower = -upper;
+    result.upper = -lower;
+    return result;
+}
+
+Interval Interval::operator*(const Interval &other) const {
+    if (IsEmpty() || other.IsEmpty()) return Empty();
+
+    long double products[] = {Product(lower, other.lower), Product(lower, other.upper),
+                              Product(upper, other.lower), Product(upper, other.upper)};
+
+    return Outward(*min_element(begin(products), end(products)), *max_element(begin(products), end(products)),
+                   arithmeticError);
+}
+
+Interval Interval::operator/(const Interval &other) const {
+    if (IsEmpty() || other.IsEmpty()) return Empty();
+
+    // Делитель без нуля: частное монотонно по каждому аргументу, крайние значения - в углах
+    if (!other.Contains(0)) {
+        long double quotients[] = {lower / other.lower, lower / other.upper, upper / other.lower, upper / other.upper};
+        return Outward(*min_element(begin(quotients), end(quotients)), *max_element(begin(quotients), end(quotients)),
+                       arithmeticError);
+    }
+
+    // На 0 делить нельзя, поэтому делитель [0, 0] не дает значений
+    if (other.IsPoint()) return Empty();
+    if (lower == 0 && upper == 0) return Interval(0);
+    // Делитель с нулем внутри дает значения сколь угодно большие по модулю с обоих знаков
+    if (other.lower < 0 && other.upper > 0) return Entire();
+
+    // Делитель (0, upper] или [lower, 0): частное уходит в бесконечность с одной стороны
+    if (other.lower == 0) {
+        if (lower >= 0) return Outward(lower / other.upper, infinity, arithmeticError);
+        if (upper <= 0) return Outward(-infinity, upper / other.upper, arithmeticError);
+    } else {
+        if (lower >= 0) return Outward(-infinity, lower / other.lower, arithmeticError);
+        if (upper <= 0) return Outward(upper / other.lower, infinity, arithmeticError);
+    }
+
+    return Entire();
+}
+
+Interval Interval::Hull(const Interval &a, const Interval &b) {
+    if (a.IsEmpty()) return b;
+    if (b.IsEmpty()) return a;
+
+    return {min(a.lower, b.lower), max(a.upper, b.upper)};
+}
+
+Interval Interval::IntegerPower(const Interval &a, long long n) {
+    if (n == 0) return Interval(1);
+    if (n < 0) return Interval(1) / IntegerPower(a, -n);
+
+    // Нечетная степень возрастает на всей прямой
+    if (n % 2 != 0) return Outward(powl(a.lower, (long double) n), powl(a.upper, (long double) n), functionError);
+
+    // Четная степень убывает до нуля и возрастает после него
+    long double smallest = (a.Contains(0) ? 0 : min(fabsl(a.lower), fabsl(a.upper)));
+    long double largest = max(fabsl(a.lower), fabsl(a.upper));
+    Interval result = Outward(powl(smallest, (long double) n), powl(largest, (long double) n), functionError);
+    result.lower = max(result.lower, 0.0L);
+
+    return result;
+}
+
+Interval Interval::NonNegativePower(const Interval &a, const Interval &b) {
+    long double corners[] = {powl(a.lower, b.lower), powl(a.lower, b.upper), powl(a.upper, b.lower),
+                             powl(a.upper, b.upper)};
+
+    Interval result = Outward(*min_element(begin(corners), end(corners)), *max_element(begin(corners), end(corners)),
+                              functionError);
+    result.lower = max(result.lower, 0.0L);
+
+    return result;
+}
+
+Interval Interval::Power(const Interval &a, const Interval &b) {
+    // Показатель уже этой относительной ширины - это округленная константа, а не диапазон
+    const long double maxWidthOfConstant = 1e-12L;
+
+    if (a.IsEmpty() || b.IsEmpty()) return Empty();
+
+    // Узкий показатель считается равным дроби p/q с небольшим знаменателем, как в BatchKernels::Power
+    long long p = 0, q = 0;
+    bool isFraction = (b.GetWidth() <= maxWidthOfConstant * max(1.0L, fabsl(b.GetMiddle())) &&
+                       FindExponentFraction(b.GetMiddle(), p, q));
+
+    // Неотрицательное основание возводится в сам показатель, даже если он близок к дроби
+    Interval result = Empty();
+    bool isExactInteger = (isFraction && q == 1 && b.IsPoint() && b.lower == (long double) p);
+    if (a.upper >= 0 && !isExactInteger) result = NonNegativePower({max(a.lower, 0.0L), a.upper}, b);
+
+    if (isFraction && q == 1) return Hull(result, IntegerPower(a, p));
+    if (a.lower >= 0) return result;
+
+    // Отрицательное основание: x^(p/q) = (-1)^p * |x|^(p/q), при четном q степень не определена,
+    // а если показатель - диапазон, знак каждого значения может быть любым
+    if (!isFraction) {
+        Interval magnitude = NonNegativePower({max(-a.upper, 0.0L), -a.lower}, b);
+        return Hull(result, Hull(magnitude, -magnitude));
+    }
+    if (q % 2 != 0) {
+        Interval exponent = Hull(b, Interval((long double) p) / Interval((long double) q));
+        Interval magnitude = NonNegativePower({max(-a.upper, 0.0L), -a.lower}, exponent);
+        result = Hull(result, (p % 2 != 0 ? -magnitude : magnitude));
+    }
+
+    return result;
+}
+
+Interval Interval::Apply(BatchKernels::TypeOfKernels kernel, const Interval &a) {
+    if (a.IsEmpty()) return a;
+
+    long double lower = a.lower, upper = a.upper;
+    bool isFinite = isfinite(lower) && isfinite(upper);
+    Interval result;
+
+    switch (kernel) {
+        case BatchKernels::plus: return a;
+        case BatchKernels::negate: return -a;
+
+        case BatchKernels::sine:
+        case BatchKernels::cosine: {
+            if (!isFinite || upper - lower >= twoPi) return {-1, 1};
+
+            // Наибольшее и наименьшее значения на периоде: у sin - в pi/2 и -pi/2, у cos - в 0 и pi
+            bool isSine = (kernel == BatchKernels::sine);
+            long double first = (isSine ? sinl(lower) : cosl(lower)), last = (isSine ? sinl(upper) : cosl(upper));
+            result = Outward(min(first, last), max(first, last), functionError);
+
+            if (ContainsPeriodPoint(lower, upper, (isSine ? halfPi : 0), twoPi)) result.upper = 1;
+            if (ContainsPeriodPoint(lower, upper, (isSine ? -halfPi : pi), twoPi)) result.lower = -1;
+            result.lower = max(result.lower, -1.0L);
+            result.upper = min(result.upper, 1.0L);
+            return result;
+        }
+
+        // tg возрастает, а ctg убывает между соседними точками разрыва
+        case BatchKernels::tangent:
+            if (!isFinite || upper - lower >= pi || ContainsPeriodPoint(lower, upper, halfPi, pi)) return Entire();
+            return Outward(tanl(lower), tanl(upper), functionError);
+        case BatchKernels::cotangent:
+            if (!isFinite || upper - lower >= pi || ContainsPeriodPoint(lower, upper, 0, pi)) return Entire();
+            return Outward(cosl(upper) / sinl(upper), cosl(lower) / sinl(lower), functionError);
+
+        // arcsin и arccos определены на [-1, 1]
+        case BatchKernels::arcsine:
+        case BatchKernels::arccosine:
+            lower = max(lower, -1.0L);
+            upper = min(upper, 1.0L);
+            if (lower > upper) return Empty();
+            if (kernel == BatchKernels::arcsine) return Outward(asinl(lower), asinl(upper), functionError);
+            return Outward(acosl(upper), acosl(lower), functionError);
+
+        case BatchKernels::arctangent: return Outward(atanl(lower), atanl(upper), functionError);
+        case BatchKernels::arccotangent: return Outward(Arccotangent(upper), Arccotangent(lower), functionError);
+
+        case BatchKernels::absolute:
+            if (lower >= 0) return a;
+            if (upper <= 0) return -a;
+            return {0, max(-lower, upper)};
+
+        // Округление вниз точное и не убывает
+        case BatchKernels::integral: return {floorl(lower), floorl(upper)};
+
+        case BatchKernels::squareRoot:
+            if (upper < 0) return Empty();
+            result = Outward(sqrtl(max(lower, 0.0L)), sqrtl(upper), arithmeticError);
+            result.lower = max(result.lower, 0.0L);
+            return result;
+
+        default:
+            throw runtime_error("Ошибка вычисления. У операции пользователя нет интервального вычисления");
+    }
+}
+
+Interval Interval::Apply(BatchKernels::TypeOfKernels kernel, const Interval &a, const Interval &b) {
+    switch (kernel) {
+        case BatchKernels::add: return a + b;
+        case BatchKernels::subtract: return a - b;
+        case BatchKernels::multiply: return a * b;
+        case BatchKernels::divide: return a / b;
+        case BatchKernels::power: return Power(a, b);
+        case BatchKernels::exponent: return a * Power(Interval(10), b);
+        default: throw runtime_error("Ошибка вычисления. У операции пользователя нет интервального вычисления");
+    }
+}
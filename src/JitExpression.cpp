@@ -0,0 +1,315 @@
+#include "../include/JitExpression.hpp"
+
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define MATHPARSER_JIT
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+#endif
+
+static atomic<bool> isPerfMapEnabled = false;
+
+#ifdef MATHPARSER_JIT
+
+using UnaryFunction = double (*)(double);
+using BinaryFunction = double (*)(double, double);
+
+// Функции, для которых нет упакованной инструкции, вызываются отдельно для каждой из двух строк
+static double Cotangent(double a) { return cos(a) / sin(a); }
+
+static double Arccotangent(double a) { return M_PI_2 - atan(a); }
+
+static double Exponent(double a, double b) { return a * BatchKernels::Power(10, b); }
+
+static UnaryFunction FindUnaryFunction(BatchKernels::TypeOfKernels kernel) {
+    switch (kernel) {
+        case BatchKernels::sine: return static_cast<UnaryFunction>(sin);
+        case BatchKernels::cosine: return static_cast<UnaryFunction>(cos);
+        case BatchKernels::tangent: return static_cast<UnaryFunction>(tan);
+        case BatchKernels::cotangent: return Cotangent;
+        case BatchKernels::arcsine: return static_cast<UnaryFunction>(asin);
+        case BatchKernels::arccosine: return static_cast<UnaryFunction>(acos);
+        case BatchKernels::arctangent: return static_cast<UnaryFunction>(atan);
+        case BatchKernels::arccotangent: return Arccotangent;
+        case BatchKernels::integral: return static_cast<UnaryFunction>(floor);
+        default: return nullptr;
+    }
+}
+
+static BinaryFunction FindBinaryFunction(BatchKernels::TypeOfKernels kernel) {
+    switch (kernel) {
+        case BatchKernels::power: return BatchKernels::Power;
+        case BatchKernels::exponent: return Exponent;
+        default: return nullptr;
+    }
+}
+
+// Регистры программы лежат в памяти по адресу rbx, по 16 байт (две строки) на регистр.
+// Во время работы кода: r12 - столбцы, r13 - номер строки, r14 - ответы, r15 - количество строк
+
+static void Emit(vector<uint8_t> &code, initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+
+static void EmitImmediate(vector<uint8_t> &code, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) code.push_back((uint8_t) (value >> (8 * i)));
+}
+
+// Инструкция SSE вида prefix 0F opcode xmm, [rbx + displacement]
+static void EmitMemory(vector<uint8_t> &code, uint8_t prefix, uint8_t opcode, int xmm, size_t displacement) {
+    Emit(code, {prefix, 0x0F, opcode, (uint8_t) (0x83 | (xmm << 3))});
+    EmitImmediate(code, displacement, 4);
+}
+
+// movupd xmm, [rbx + displacement] и movupd [rbx + displacement], xmm
+static void EmitLoad(vector<uint8_t> &code, int xmm, size_t displacement) {
+    EmitMemory(code, 0x66, 0x10, xmm, displacement);
+}
+
+static void EmitStore(vector<uint8_t> &code, int xmm, size_t displacement) {
+    EmitMemory(code, 0x66, 0x11, xmm, displacement);
+}
+
+// Записывает value в обе половины xmm0 или xmm1 через rax
+static void EmitBroadcast(vector<uint8_t> &code, int xmm, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    // mov rax, imm64; movq xmm, rax; punpcklqdq xmm, xmm
+    Emit(code, {0x48, 0xB8});
+    EmitImmediate(code, bits, 8);
+    Emit(code, {0x66, 0x48, 0x0F, 0x6E, (uint8_t) (0xC0 | (xmm << 3))});
+    Emit(code, {0x66, 0x0F, 0x6C, (uint8_t) (0xC0 | (xmm << 3) | xmm)});
+}
+
+// mov rax, imm64; call rax
+static void EmitCall(vector<uint8_t> &code, const void *function) {
+    Emit(code, {0x48, 0xB8});
+    EmitImmediate(code, (uint64_t) function, 8);
+    Emit(code, {0xFF, 0xD0});
+}
+
+#endif
+
+JitExpression::JitExpression(const CompiledExpression &expression) : compiled(expression) {
+#ifdef MATHPARSER_JIT
+    vector<uint8_t> machineCode = Generate();
+    if (machineCode.empty()) return;
+
+    // Память сначала доступна для записи, затем только для исполнения
+    void *buffer = mmap(nullptr, machineCode.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) return;
+
+    memcpy(buffer, machineCode.data(), machineCode.size());
+    if (mprotect(buffer, machineCode.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(buffer, machineCode.size());
+        return;
+    }
+
+    memory = buffer;
+    sizeOfMemory = machineCode.size();
+    code = reinterpret_cast<Code>(memory);
+
+    if (isPerfMapEnabled) WritePerfMap();
+#endif
+}
+
+JitExpression::~JitExpression() {
+#ifdef MATHPARSER_JIT
+    if (memory) munmap(memory, sizeOfMemory);
+#endif
+}
+
+vector<uint8_t> JitExpression::Generate() const {
+    vector<uint8_t> machineCode;
+
+#ifdef MATHPARSER_JIT
+    const size_t sizeOfRegister = 2 * sizeof(double);
+    vector<uint8_t> &code = machineCode;
+
+    // push rbx, r12, r13, r14, r15 - после пяти сохранений стек выровнен на 16 байт для вызовов функций
+    Emit(code, {0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});
+    // mov r12, rdi; mov r14, rsi; mov r15, rdx; mov rbx, rcx; xor r13d, r13d
+    Emit(code, {0x49, 0x89, 0xFC, 0x49, 0x89, 0xF6, 0x49, 0x89, 0xD7, 0x48, 0x89, 0xCB, 0x45, 0x31, 0xED});
+
+    // Начало цикла по парам строк: lea rax, [r13 + 2]; cmp rax, r15; ja конец
+    size_t loop = code.size();
+    Emit(code, {0x49, 0x8D, 0x45, 0x02, 0x4C, 0x39, 0xF8, 0x0F, 0x87});
+    size_t exitJump = code.size();
+    EmitImmediate(code, 0, 4);
+
+    for (const auto &iter: compiled.instructions) {
+        const size_t *operand = compiled.operands.data() + iter.firstOperand;
+        size_t target = iter.result * sizeOfRegister;
+
+        if (iter.type == CompiledExpression::constant) {
+            EmitBroadcast(code, 0, compiled.doubleConstants[iter.index]);
+            EmitStore(code, 0, target);
+            continue;
+        }
+
+        if (iter.type == CompiledExpression::variable) {
+            // mov rax, [r12 + 8 * index]; movupd xmm0, [rax + 8 * r13]
+            Emit(code, {0x49, 0x8B, 0x84, 0x24});
+            EmitImmediate(code, iter.index * sizeof(double *), 4);
+            Emit(code, {0x66, 0x42, 0x0F, 0x10, 0x04, 0xE8});
+            EmitStore(code, 0, target);
+            continue;
+        }
+
+        size_t a = operand[0] * sizeOfRegister;
+
+        switch (iter.kernel) {
+            case BatchKernels::plus:
+                EmitLoad(code, 0, a);
+                EmitStore(code, 0, target);
+                break;
+
+            case BatchKernels::negate:
+                // xorpd xmm0, xmm1 со знаковым битом
+                EmitBroadcast(code, 1, -0.0);
+                EmitLoad(code, 0, a);
+                Emit(code, {0x66, 0x0F, 0x57, 0xC1});
+                EmitStore(code, 0, target);
+                break;
+
+            case BatchKernels::absolute:
+                // andnpd xmm1, [a] сбрасывает знаковый бит
+                EmitBroadcast(code, 1, -0.0);
+                EmitMemory(code, 0x66, 0x55, 1, a);
+                EmitStore(code, 1, target);
+                break;
+
+            case BatchKernels::squareRoot:
+                EmitMemory(code, 0x66, 0x51, 0, a);
+                EmitStore(code, 0, target);
+                break;
+
+            case BatchKernels::add:
+            case BatchKernels::subtract:
+            case BatchKernels::multiply:
+            case BatchKernels::divide: {
+                // addpd, subpd, mulpd, divpd
+                const uint8_t opcode = (iter.kernel == BatchKernels::add ? 0x58 :
+                                        iter.kernel == BatchKernels::subtract ? 0x5C :
+                                        iter.kernel == BatchKernels::multiply ? 0x59 : 0x5E);
+                EmitLoad(code, 0, a);
+                EmitMemory(code, 0x66, opcode, 0, operand[1] * sizeOfRegister);
+                EmitStore(code, 0, target);
+                break;
+            }
+
+            default: {
+                UnaryFunction unary = (iter.type == CompiledExpression::binaryOperation ? nullptr
+                                                                                       : FindUnaryFunction(iter.kernel));
+                BinaryFunction binary = (iter.type == CompiledExpression::binaryOperation
+                                         ? FindBinaryFunction(iter.kernel) : nullptr);
+
+                // Операцию без ядра вычисляет только интерпретатор
+                if (!unary && !binary) return {};
+
+                // Для каждой строки: movsd xmm0, [a]; movsd xmm1, [b]; call; movsd [target], xmm0
+                for (size_t lane = 0; lane < 2; lane++) {
+                    size_t offset = lane * sizeof(double);
+                    EmitMemory(code, 0xF2, 0x10, 0, a + offset);
+                    if (binary) EmitMemory(code, 0xF2, 0x10, 1, operand[1] * sizeOfRegister + offset);
+                    EmitCall(code, (unary ? (const void *) unary : (const void *) binary));
+                    EmitMemory(code, 0xF2, 0x11, 0, target + offset);
+                }
+                break;
+            }
+        }
+    }
+
+    // movupd xmm0, [root]; movupd [r14 + 8 * r13], xmm0
+    EmitLoad(code, 0, compiled.instructions.back().result * sizeOfRegister);
+    Emit(code, {0x66, 0x43, 0x0F, 0x11, 0x04, 0xEE});
+
+    // add r13, 2; jmp начало цикла
+    Emit(code, {0x49, 0x83, 0xC5, 0x02, 0xE9});
+    EmitImmediate(code, (uint64_t) (loop - (code.size() + 4)), 4);
+
+    uint32_t exitOffset = (uint32_t) (code.size() - (exitJump + 4));
+    memcpy(code.data() + exitJump, &exitOffset, sizeof(exitOffset));
+
+    // pop r15, r14, r13, r12, rbx; ret
+    Emit(code, {0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});
+#endif
+
+    return machineCode;
+}
+
+void JitExpression::WritePerfMap() const {
+#ifdef MATHPARSER_JIT
+    static mutex lock;
+    static size_t numberOfExpressions = 0;
+
+    lock_guard<mutex> guard(lock);
+
+    string fileName = "/tmp/perf-" + to_string(getpid()) + ".map";
+    FILE *file = fopen(fileName.c_str(), "a");
+    if (!file) return;
+
+    // Формат perf: начало и размер в шестнадцатеричном виде, затем имя символа
+    string name = "mathparser_jit_" + to_string(numberOfExpressions++) + "(";
+    for (size_t i = 0; i < compiled.variables.size(); i++) name += (i ? "," : "") + compiled.variables[i];
+    name += ")";
+
+    fprintf(file, "%lx %zx %s\n", (unsigned long) memory, sizeOfMemory, name.c_str());
+    fclose(file);
+#endif
+}
+
+bool JitExpression::IsCompiled() const { return code != nullptr; }
+
+double JitExpression::Eval(span<const double> values) const {
+    vector<const double *> columns;
+    double result = 0;
+
+    if (values.size() < compiled.variables.size())
+        throw runtime_error("Ошибка. Не задано значение переменной " + compiled.variables[values.size()]);
+
+    for (const auto &iter: values) columns.push_back(&iter);
+    EvalBatch(columns, span<double>(&result, 1));
+
+    return result;
+}
+
+void JitExpression::EvalBatch(span<const double *const> columns, span<double> result) const {
+    if (!code) {
+        compiled.EvalBatch(columns, result);
+        return;
+    }
+
+    if (columns.size() < compiled.variables.size())
+        throw runtime_error("Ошибка. Не задан столбец переменной " + compiled.variables[columns.size()]);
+
+    vector<double> registers(compiled.numberOfRegisters * 2);
+    size_t size = result.size() - result.size() % 2;
+
+    code(columns.data(), result.data(), size, registers.data());
+
+    if (size == result.size()) return;
+
+    // Машинный код обрабатывает строки парами, поэтому последняя нечетная строка повторяется дважды
+    vector<double> lastRow(2 * compiled.variables.size());
+    vector<const double *> lastColumns;
+    double lastResult[2];
+
+    for (size_t i = 0; i < compiled.variables.size(); i++) {
+        lastRow[2 * i] = lastRow[2 * i + 1] = columns[i][size];
+        lastColumns.push_back(lastRow.data() + 2 * i);
+    }
+
+    code(lastColumns.data(), lastResult, 2, registers.data());
+    result[size] = lastResult[0];
+}
+
+const vector<string> &JitExpression::GetVariables() const { return compiled.variables; }
+
+void JitExpression::SetPerfMapEnabled(bool isEnabled) { isPerfMapEnabled = isEnabled; }
@@ -1,78 +1,142 @@
 #include "../include/MathParser.hpp"
 
-bool MathExpression::IsDigit(const size_t &position) { return isdigit(expression[position]); }
+#include <array>
 
-bool MathExpression::IsPoint(const size_t &position) { return expression[position] == '.'; }
+// Классы символов, символ может входить в несколько классов сразу
+enum : uint8_t {
+    digitSymbol = 1, pointSymbol = 2, letterSymbol = 4, underscoreSymbol = 8, spaceSymbol = 16
+};
 
-bool MathExpression::IsLetter(const size_t &position) { return isalpha(expression[position]); }
+// Таблица классов для всех 256 значений char, не зависит от локали в отличие от isdigit/isalpha
+static constexpr array<uint8_t, 256> symbolClasses = [] {
+    array<uint8_t, 256> classes{};
 
-bool MathExpression::IsBracketSequenceCorrect() {
-    // переменная для подсчета открывающих и закрывающих скобок
-    int count = 0;
+    for (int symbol = '0'; symbol <= '9'; symbol++) classes[symbol] = digitSymbol;
+    for (int symbol = 'a'; symbol <= 'z'; symbol++) classes[symbol] = classes[symbol - 'a' + 'A'] = letterSymbol;
+    classes['.'] = pointSymbol;
+    classes['_'] = underscoreSymbol;
+    for (char symbol: {' ', '\t', '\n', '\v', '\f', '\r'}) classes[(unsigned char) symbol] = spaceSymbol;
 
-    for (char &iter: expression) {
-        // каждая открывающая скобка увеличивает счетчик
-        if (iter == '(') count++;
-            // каждая закрывающая скобка уменьшает счетчик
-        else if (iter == ')') count--;
+    return classes;
+}();
 
-        // если количество станет меньше нуля, значит скобки расставлены неправильно
-        if (count < 0) return false;
-    }
+MathExpression::MathExpression(const string &expr) : MathExpression(expr, Operations::GetInstance().GetSnapshot()) {}
+
+MathExpression::MathExpression(const string &expr, const EvaluationContext &context)
+        : MathExpression(expr, context.operations.GetSnapshot()) {}
+
+MathExpression::MathExpression(const string &expr, shared_ptr<const Operations::Snapshot> operations)
+        : operations(std::move(operations)), expression(expr) {
+    if (expression.empty()) throw runtime_error("Ошибка. Пустое выражение");
 
-    // если count = 0, то открывающих и закрывающих скобок одинаковое количество
-    return count == 0;
+    // Имена операций, функций и переменных не зависят от регистра
+    for (char &symbol: expression)
+        if (symbolClasses[(unsigned char) symbol] & letterSymbol) symbol = (char) (symbol | 0x20);
 }
 
-MathExpression::TypeOfTokens MathExpression::GetTokenType(size_t position, const string &name) {
-    TypeOfTokens type = unknown;
+string_view MathExpression::GetName(const Token &token) const {
+    return string_view(expression).substr(token.offset, token.length);
+}
+
+uint8_t MathExpression::GetSymbolClass(size_t position) const {
+    return (position < expression.size() ? symbolClasses[(unsigned char) expression[position]] : 0);
+}
 
-    if (operations.IsFunction(name)) {
-        while (position < expression.size() && isspace(expression[position])) position++;
-        if (expression[position] == '(') type = func;
-        else throw runtime_error("Ошибка. После функции " + name + " ожидается '('");
+MathExpression::TypeOfTokens MathExpression::GetTokenType(size_t position, Token &token,
+                                                          const Operations::Descriptor *descriptor) {
+    string_view name = GetName(token);
+    TypeOfTokens type = unknown;
+    const Operations::Function *function = (descriptor ? descriptor->function : nullptr);
+    const Operations::UnaryOperation *unary = (descriptor ? descriptor->unary : nullptr);
+    const Operations::BinaryOperation *binary = (descriptor ? descriptor->binary : nullptr);
+
+    if (function) {
+        while (GetSymbolClass(position) & spaceSymbol) position++;
+        if (position < expression.size() && expression[position] == '(') type = func;
+        else throw runtime_error("Ошибка. После функции " + string(name) + " ожидается '('");
     }
         // Если операция является и бинарной, и унарной
-    else if (operations.IsUnaryOperation(name) && operations.IsBinaryOperation(name)) {
-        // Получаем позицию символа перед операцией, -1 - означает, что операция находится в начале строки
-        position -= name.size() + 1;
-        while (position > 0 && isspace(expression[position])) position--;
-        type = ((position != -1 && (IsDigit(position) || IsPoint(position) || expression[position] == ')'))
+    else if (unary && binary) {
+        // Операция бинарная, если перед ней стоит операнд: число, переменная или закрывающая скобка
+        type = ((previousTokenType == number || previousTokenType == variable || previousTokenType == closeBracket)
                 ? binaryOperation : unaryOperation);
-    } else if (operations.IsUnaryOperation(name)) type = unaryOperation;
-    else if (operations.IsBinaryOperation(name))type = binaryOperation;
+    } else if (unary) type = unaryOperation;
+    else if (binary) type = binaryOperation;
     else if (name == "(") type = openBracket;
     else if (name == ")") type = closeBracket;
+        // Любое другое слово, начинающееся с буквы, является переменной
+    else if (!name.empty() && (symbolClasses[(unsigned char) name[0]] & letterSymbol)) type = variable;
+
+    // Сохраняем найденное описание, чтобы после разбора не искать операцию по имени
+    if (type == func) {
+        token.function = function;
+        token.priority = function->priority;
+    } else if (type == unaryOperation) {
+        token.unary = unary;
+        token.priority = unary->priority;
+    } else if (type == binaryOperation) {
+        token.binary = binary;
+        token.priority = binary->priority;
+    }
 
     return type;
 }
 
 MathExpression::Token MathExpression::GetToken() {
-    string tokenName;
     Token token;
-
-    while (index < expression.size() && isspace(expression[index]))
-        index++;
-
-    // Если встречаем цифру, получаем полностью число
-    while (index < expression.size() && (IsDigit(index) || IsPoint(index)))
-        tokenName += expression[index++];
-    if (!tokenName.empty())
+    // Запись реестра для имени токена, ищется один раз
+    const Operations::Descriptor *descriptor = nullptr;
+
+    while (GetSymbolClass(index) & spaceSymbol) index++;
+
+    token.offset = index;
+
+    // Если встречаем цифру, получаем полностью число вместе с показателем степени и сразу вычисляем его значение
+    if (GetSymbolClass(index) & (digitSymbol | pointSymbol)) {
+        Fraction::Decimal decimal = Fraction::ScanDecimal(string_view(expression).substr(index));
+        index += decimal.length;
+        if (!decimal.isValid)
+            throw runtime_error("Ошибка. Некорректное число " + expression.substr(token.offset, decimal.length));
+
+        // Число, которое не помещается в Fraction, вычисляется только точно
+        try {
+            token.value = Fraction::FromDecimal(decimal);
+            token.isExact = (!decimal.isTruncated && decimal.exponent >= -18);
+        } catch (runtime_error &error) {
+            token.isLarge = true;
+        }
         token.type = number;
+    }
         // Если встречаем букву, получаем полностью слово
-    else if (IsLetter(index))
-        while (index < expression.size() && IsLetter(index))
-            tokenName += (char) tolower(expression[index++]);
+    else if (GetSymbolClass(index) & letterSymbol) {
+        while (GetSymbolClass(index) & letterSymbol) index++;
+
+        // Если слово не является операцией или функцией, то это имя переменной, которое может содержать цифры и '_'
+        descriptor = operations->Find(string_view(expression).substr(token.offset, index - token.offset));
+        if (!descriptor && (GetSymbolClass(index) & (digitSymbol | underscoreSymbol))) {
+            while (GetSymbolClass(index) & (letterSymbol | digitSymbol | underscoreSymbol)) index++;
+            // Пользовательская функция может иметь имя с цифрами, например log10
+            descriptor = operations->Find(string_view(expression).substr(token.offset, index - token.offset));
+        }
+    }
         // Иначе получаем символ
-    else if (index < expression.size()) tokenName += expression[index++];
+    else if (index < expression.size()) descriptor = operations->Find(string_view(expression).substr(index++, 1));
 
-    if (tokenName == ",") token.type = comma;
+    token.length = index - token.offset;
+
+    if (token.length == 1 && expression[token.offset] == ',') token.type = comma;
 
     // Устанавливаем тип операции
-    if (token.type == unknown) token.type = GetTokenType(index, tokenName);
+    if (token.type == unknown) token.type = GetTokenType(index, token, descriptor);
+
+    // Скобочная последовательность проверяется в том же проходе, что и разбор на токены
+    if (token.type == openBracket) numberOfOpenBrackets++;
+    else if (token.type == closeBracket) {
+        if (numberOfOpenBrackets == 0) throw runtime_error("Ошибка. Некорректная скобочная последовательность");
+        numberOfOpenBrackets--;
+    }
 
-    if (index < expression.size() && tokenName.empty()) throw runtime_error("Ошибка. Непредвиденный символ");
-    token.name = tokenName;
+    previousTokenType = token.type;
 
     return token;
 }
@@ -80,13 +144,21 @@ MathExpression::Token MathExpression::GetToken() {
 void MathExpression::BuildPostfixNotation() {
     stack<Token> tokens;
 
+    // Разбор всегда начинается с начала строки, поэтому повторный вызов не дублирует нотацию
+    index = 0;
+    previousTokenType = unknown;
+    numberOfOpenBrackets = 0;
+    postfixNotationExpression.clear();
+
+    size_t numberOfCommas;
+
     while (index < expression.size()) {
         Token token = GetToken();
 
         switch (token.type) {
             // если дошли до конца строки и токен пустой, то прерываем цикл
             case unknown:
-                if (index == expression.size() && token.name.empty()) break;
+                if (index == expression.size() && token.length == 0) break;
                 throw runtime_error("Ошибка. Такой операции нет");
 
             case comma:
@@ -94,7 +166,10 @@ void MathExpression::BuildPostfixNotation() {
                     postfixNotationExpression.push_back(tokens.top());
                     tokens.pop();
                 }
+                // Считаем запятые внутри скобки, чтобы знать количество аргументов функции
+                if (!tokens.empty()) tokens.top().numberOfArguments++;
             case number:
+            case variable:
                 postfixNotationExpression.push_back(token);
                 break;
 
@@ -104,11 +179,13 @@ void MathExpression::BuildPostfixNotation() {
                     postfixNotationExpression.push_back(tokens.top());
                     tokens.pop();
                 }
+                numberOfCommas = tokens.top().numberOfArguments;
                 tokens.pop();
 
                 // Когда дошли до открывающей скобки, проверяем на наличие функции перед ней
                 if (!tokens.empty() && tokens.top().type == func) {
                     postfixNotationExpression.push_back(tokens.top());
+                    postfixNotationExpression.back().numberOfArguments = numberOfCommas + 1;
                     tokens.pop();
                 }
 
@@ -118,8 +195,7 @@ void MathExpression::BuildPostfixNotation() {
                 // Пока на вершине стека унарная операция или бинарная с большим или равным приоритетом, добавляем токен в обратную нотацию
                 while (!tokens.empty() &&
                        (tokens.top().type == binaryOperation || tokens.top().type == unaryOperation) &&
-                       operations.priorities[token.name] <=
-                       operations.priorities[tokens.top().name]) {
+                       token.priority <= tokens.top().priority) {
                     postfixNotationExpression.push_back(tokens.top());
                     tokens.pop();
                 }
@@ -131,6 +207,8 @@ void MathExpression::BuildPostfixNotation() {
         }
     }
 
+    if (numberOfOpenBrackets != 0) throw runtime_error("Ошибка. Некорректная скобочная последовательность");
+
     // Если дошли до конца выражения, то добавляем оставшиеся токены в обратную нотацию
     if (index == expression.size()) {
         while (!tokens.empty()) {
@@ -140,71 +218,146 @@ void MathExpression::BuildPostfixNotation() {
     }
 }
 
-Fraction MathExpression::Eval() {
-    stack<Fraction> numbers;
-    vector<Fraction> args;
-    Fraction a, b, x;
+CompiledExpression MathExpression::Compile() { return Compile(vector<string>(), true); }
+
+CompiledExpression MathExpression::Compile(const vector<string> &variables) { return Compile(variables, false); }
+
+CompiledExpression MathExpression::Compile(const vector<string> &variables, bool canAddVariables) {
+    CompiledExpression compiled;
+    // Индексы ячеек переменных, имена приводятся к нижнему регистру так же, как при разборе
+    map<string, size_t, less<>> variableIndexes;
+
+    for (const auto &name: variables) {
+        string lowerName = CompiledExpression::ToLowerName(name);
+
+        if (variableIndexes.count(lowerName)) throw runtime_error("Ошибка. Переменная " + name + " задана дважды");
+        variableIndexes[lowerName] = compiled.variables.size();
+        compiled.variables.push_back(lowerName);
+    }
+
+    // Индексы уже добавленных в пулы операций, чтобы каждая операция копировалась один раз
+    map<const Operations::UnaryOperation *, size_t> unaryIndexes;
+    map<const Operations::BinaryOperation *, size_t> binaryIndexes;
+    map<const Operations::Function *, size_t> functionIndexes;
+    // Глубина стека чисел, которую будет иметь вычисление после текущей инструкции
+    size_t depth = 0;
 
     BuildPostfixNotation();
 
     for (const auto &iter: postfixNotationExpression) {
+        CompiledExpression::Instruction instruction{CompiledExpression::constant, 0, 0, BatchKernels::generic, true, 0, 0};
+
         switch (iter.type) {
             case comma:
-                if (numbers.empty()) throw runtime_error("Ошибка. Ожидается операнд");
-
-                args.push_back(numbers.top());
-                numbers.pop();
+                if (depth == 0) throw runtime_error("Ошибка. Ожидается операнд");
+                continue;
 
+            case number:
+                instruction.index = compiled.constants.size();
+                compiled.constants.push_back(iter.value);
+                // Запись числа разбирается заново только тогда, когда значение токена неточное
+                if (iter.isExact) compiled.exactConstants.emplace_back(iter.value);
+                else {
+                    try {
+                        compiled.exactConstants.emplace_back(string(GetName(iter)));
+                    } catch (runtime_error &error) {
+                        // Порядок слишком велик и для точного числа: остается приближенное значение токена
+                        if (iter.isLarge) throw;
+                        compiled.exactConstants.emplace_back(iter.value);
+                        // Такое число меньше любого положительного long double
+                        compiled.intervalConstants.emplace_back(0, numeric_limits<long double>::denorm_min());
+                    }
+                }
+                if (compiled.intervalConstants.size() < compiled.exactConstants.size())
+                    compiled.intervalConstants.emplace_back(compiled.exactConstants.back());
+                if (iter.isLarge) compiled.hasLargeConstants = true;
+                depth++;
                 break;
 
-            case number:
-                numbers.push(Fraction(iter.name));
+            case variable: {
+                auto found = variableIndexes.find(GetName(iter));
+                if (found == variableIndexes.end()) {
+                    string name(GetName(iter));
+                    if (!canAddVariables) throw runtime_error("Ошибка. Неизвестная переменная " + name);
+                    found = variableIndexes.emplace(name, compiled.variables.size()).first;
+                    compiled.variables.push_back(name);
+                }
+
+                instruction.type = CompiledExpression::variable;
+                instruction.index = found->second;
+                depth++;
                 break;
+            }
 
             case unaryOperation:
-                if (numbers.empty()) throw runtime_error("Ошибка вычисления. Пропущен операнд");
-
-                x = numbers.top();
-                numbers.pop();
+                if (depth < 1) throw runtime_error("Ошибка вычисления. Пропущен операнд");
 
-                numbers.push(operations.unaryOperations[iter.name](x));
+                instruction.type = CompiledExpression::unaryOperation;
+                if (!unaryIndexes.count(iter.unary)) {
+                    unaryIndexes[iter.unary] = compiled.unaryOperations.size();
+                    compiled.unaryOperations.push_back(iter.unary->func);
+                }
+                instruction.index = unaryIndexes[iter.unary];
+                instruction.numberOfArguments = 1;
+                instruction.kernel = iter.unary->kernel;
+                instruction.isPure = iter.unary->isPure;
                 break;
 
             case binaryOperation:
-                if (numbers.empty()) throw runtime_error("Ошибка вычисления. Пропущен операнд");
+                if (depth < 2) throw runtime_error("Ошибка вычисления. Пропущен операнд");
 
-                b = numbers.top();
-                numbers.pop();
-
-                if (numbers.empty()) throw runtime_error("Ошибка вычисления. Пропущен операнд");
-
-                a = numbers.top();
-                numbers.pop();
-
-                numbers.push(operations.binaryOperations[iter.name](a, b));
+                instruction.type = CompiledExpression::binaryOperation;
+                if (!binaryIndexes.count(iter.binary)) {
+                    binaryIndexes[iter.binary] = compiled.binaryOperations.size();
+                    compiled.binaryOperations.push_back(iter.binary->func);
+                }
+                instruction.index = binaryIndexes[iter.binary];
+                instruction.numberOfArguments = 2;
+                instruction.kernel = iter.binary->kernel;
+                instruction.isPure = iter.binary->isPure;
+                depth--;
                 break;
 
-            case func:
-                if (numbers.empty()) throw runtime_error("Ошибка. Пропущен аргумент функции");
-
-                args.push_back(numbers.top());
-                numbers.pop();
+            case func: {
+                if (depth < iter.numberOfArguments) throw runtime_error("Ошибка. Пропущен аргумент функции");
 
-                int numberOfArguments = operations.numberOfFunctionArguments[iter.name];
+                int numberOfArguments = iter.function->numberOfArguments;
 
-                if (numberOfArguments != 0 && args.size() > numberOfArguments)
-                    throw runtime_error("Ошибка вычисления. Функция " + iter.name +
+                if (numberOfArguments != 0 && iter.numberOfArguments > (size_t) numberOfArguments)
+                    throw runtime_error("Ошибка вычисления. Функция " + string(GetName(iter)) +
                                         " принимает количество аргументов = " + to_string(numberOfArguments));
 
-                numbers.push(operations.functions[iter.name](args));
-                args.clear();
+                instruction.type = CompiledExpression::func;
+                if (!functionIndexes.count(iter.function)) {
+                    functionIndexes[iter.function] = compiled.functions.size();
+                    compiled.functions.push_back(iter.function->func);
+                }
+                instruction.index = functionIndexes[iter.function];
+                instruction.numberOfArguments = iter.numberOfArguments;
+                // Ядра встроенных функций рассчитаны на один аргумент
+                if (iter.numberOfArguments == 1) instruction.kernel = iter.function->kernel;
+                instruction.isPure = iter.function->isPure;
+                depth -= iter.numberOfArguments - 1;
                 break;
+            }
+
+            default:
+                continue;
         }
+
+        // Чистые операции над константами вычисляются один раз при компиляции
+        if (!instruction.isPure || !compiled.FoldInstruction(instruction)) compiled.instructions.push_back(instruction);
     }
 
-    if (numbers.size() > 1) throw runtime_error("Ошибка вычисления. Пропущен оператор или функция");
+    if (depth > 1) throw runtime_error("Ошибка вычисления. Пропущен оператор или функция");
 
-    if (numbers.empty()) throw runtime_error("Ошибка вычисления. Лишний оператор или функция");
+    if (depth == 0) throw runtime_error("Ошибка вычисления. Лишний оператор или функция");
 
-    return numbers.top();
+    compiled.BuildGraph();
+
+    return compiled;
 }
+
+Fraction MathExpression::Eval() { return Compile().Eval(); }
+
+BigRational MathExpression::EvalExact() { return Compile().EvalExact(); }
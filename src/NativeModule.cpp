@@ -0,0 +1,319 @@
+#include "../include/NativeModule.hpp"
+#include "../include/MathParser.hpp"
+
+#include <cmath>
+#include <cerrno>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#include <pwd.h>
+#include <spawn.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+// Хеш FNV-1a, по нему строится имя библиотеки в кэше
+static uint64_t Hash(const string &text) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (char symbol: text) {
+        hash ^= (unsigned char) symbol;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Проверяет, что путь принадлежит текущему пользователю и другие пользователи не могут его изменить
+static bool IsPrivate(const struct stat &status) {
+    return status.st_uid == geteuid() && (status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Создает недостающие каталоги пути с правами 0700 и проверяет, что последний из них закрыт от других пользователей
+static void PrepareDirectory(const string &directory) {
+    string prefix;
+
+    for (const auto &iter: filesystem::path(directory)) {
+        prefix = (prefix.empty() || prefix.back() == '/' ? prefix : prefix + "/") + iter.string();
+        if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST)
+            throw runtime_error("Ошибка. Не удалось создать каталог кэша " + directory);
+    }
+
+    struct stat status{};
+    if (stat(directory.c_str(), &status) != 0 || !S_ISDIR(status.st_mode) || !IsPrivate(status))
+        throw runtime_error("Ошибка. Каталог кэша " + directory + " доступен для записи другим пользователям");
+}
+
+// Делит строку на слова по пробелам, так задаются компилятор и флаги
+static vector<string> Split(const string &text) {
+    vector<string> words;
+    istringstream stream(text);
+
+    for (string word; stream >> word;) words.push_back(word);
+
+    return words;
+}
+
+// Запускает программу с аргументами argv без командной оболочки и возвращает true, если она завершилась успешно
+static bool Run(const vector<string> &argv) {
+    vector<char *> pointers;
+    for (const auto &iter: argv) pointers.push_back(const_cast<char *>(iter.c_str()));
+    pointers.push_back(nullptr);
+
+    pid_t process;
+    if (posix_spawnp(&process, pointers[0], nullptr, nullptr, pointers.data(), environ) != 0) return false;
+
+    int status;
+    while (waitpid(process, &status, 0) < 0)
+        if (errno != EINTR) return false;
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Точная запись double в исходном коде
+static string ToLiteral(double value) {
+    if (isnan(value)) return "(0.0 / 0.0)";
+    if (isinf(value)) return (value > 0 ? "(1.0 / 0.0)" : "(-1.0 / 0.0)");
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%a", value);
+    return buffer;
+}
+
+// Выражение C++ для операции с ядром, a и b - имена значений операндов
+static string GetKernelCode(BatchKernels::TypeOfKernels kernel, const string &a, const string &b) {
+    switch (kernel) {
+        case BatchKernels::plus: return a;
+        case BatchKernels::negate: return "-" + a;
+        case BatchKernels::add: return a + " + " + b;
+        case BatchKernels::subtract: return a + " - " + b;
+        case BatchKernels::multiply: return a + " * " + b;
+        case BatchKernels::divide: return a + " / " + b;
+        case BatchKernels::power: return "mathparser_power(" + a + ", " + b + ")";
+        case BatchKernels::exponent: return a + " * mathparser_power(10, " + b + ")";
+        case BatchKernels::sine: return "std::sin(" + a + ")";
+        case BatchKernels::cosine: return "std::cos(" + a + ")";
+        case BatchKernels::tangent: return "std::tan(" + a + ")";
+        case BatchKernels::cotangent: return "std::cos(" + a + ") / std::sin(" + a + ")";
+        case BatchKernels::arcsine: return "std::asin(" + a + ")";
+        case BatchKernels::arccosine: return "std::acos(" + a + ")";
+        case BatchKernels::arctangent: return "std::atan(" + a + ")";
+        case BatchKernels::arccotangent: return ToLiteral(M_PI_2) + " - std::atan(" + a + ")";
+        case BatchKernels::absolute: return "std::fabs(" + a + ")";
+        case BatchKernels::integral: return "std::floor(" + a + ")";
+        case BatchKernels::squareRoot: return "std::sqrt(" + a + ")";
+        default: return "";
+    }
+}
+
+NativeModule::NativeModule(const vector<string> &expressions, const string &cacheDirectory, const string &compiler,
+                           const string &flags) {
+    for (const auto &iter: expressions) this->expressions.push_back(MathExpression(iter).Compile());
+
+    Generate();
+
+    // В ключ кэша входят исходный код, компилятор и флаги
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long) Hash(source + '\n' + compiler + ' ' + flags));
+    string directory = (cacheDirectory.empty() ? GetDefaultCacheDirectory() : cacheDirectory);
+    path = directory + "/mathparser-" + key + ".so";
+
+    PrepareDirectory(directory);
+    isLoadedFromCache = filesystem::exists(path);
+
+    if (!isLoadedFromCache) {
+        error_code error;
+
+        // Собираем во временный файл и переименовываем, чтобы другой процесс не загрузил недописанную библиотеку
+        string temporaryPath = path + "." + to_string(getpid());
+        string sourcePath = temporaryPath + ".cpp";
+
+        // Компилятор запускается без оболочки, поэтому пути с пробелами и кавычками передаются как есть
+        vector<string> argv = Split(compiler);
+        if (argv.empty()) throw runtime_error("Ошибка. Не задан компилятор модуля");
+        for (const auto &iter: Split(flags)) argv.push_back(iter);
+        argv.insert(argv.end(), {"-o", temporaryPath, sourcePath});
+
+        ofstream(sourcePath) << source;
+
+        bool isBuilt = Run(argv);
+        filesystem::remove(sourcePath, error);
+
+        if (!isBuilt || chmod(temporaryPath.c_str(), 0700) != 0) {
+            filesystem::remove(temporaryPath, error);
+            string command;
+            for (const auto &iter: argv) command += (command.empty() ? "" : " ") + iter;
+            throw runtime_error("Ошибка. Не удалось собрать модуль: " + command);
+        }
+
+        filesystem::rename(temporaryPath, path, error);
+        if (error) throw runtime_error("Ошибка. Не удалось сохранить модуль в кэш " + path);
+    }
+
+    Load();
+}
+
+string NativeModule::GetDefaultCacheDirectory() {
+    // Каталог кэша пользователя по XDG: $XDG_CACHE_HOME, иначе ~/.cache
+    const char *cache = getenv("XDG_CACHE_HOME");
+    if (cache && cache[0] == '/') return string(cache) + "/mathparser";
+
+    const char *home = getenv("HOME");
+    if (!home || home[0] != '/') {
+        const struct passwd *user = getpwuid(geteuid());
+        home = (user ? user->pw_dir : nullptr);
+    }
+    if (!home || home[0] != '/') throw runtime_error("Ошибка. Не удалось определить домашний каталог для кэша");
+
+    return string(home) + "/.cache/mathparser";
+}
+
+NativeModule::~NativeModule() {
+    if (handle) dlclose(handle);
+}
+
+void NativeModule::Generate() {
+    ostringstream code;
+
+    // Таблица переходов и функция степени передаются функциям выражений модулем при каждом вызове
+    code << "// Сгенерировано NativeModule\n"
+         << "#include <cmath>\n"
+         << "#include <cstddef>\n\n"
+         << "extern \"C\" {\n\n"
+         << "struct mathparser_trampoline {\n"
+         << "    double (*call)(void *context, const double *args, std::size_t numberOfArguments);\n"
+         << "    void *context;\n"
+         << "};\n\n";
+
+    for (size_t number = 0; number < expressions.size(); number++) {
+        const CompiledExpression &expression = expressions[number];
+        // Номер инструкции, значение которой сейчас хранится в регистре
+        vector<size_t> registerValues(expression.numberOfRegisters);
+
+        code << "void mathparser_expression_" << number
+             << "(const double *const *columns, double *result, std::size_t size,\n"
+             << "        const mathparser_trampoline *mathparser_trampolines,\n"
+             << "        double (*mathparser_power)(double, double)) {\n"
+             << "    for (std::size_t row = 0; row < size; row++) {\n";
+
+        for (size_t i = 0; i < expression.instructions.size(); i++) {
+            const auto &iter = expression.instructions[i];
+            const size_t *operand = expression.operands.data() + iter.firstOperand;
+            string value;
+
+            if (iter.type == CompiledExpression::constant)
+                value = ToLiteral(expression.doubleConstants[iter.index]);
+            else if (iter.type == CompiledExpression::variable)
+                value = "columns[" + to_string(iter.index) + "][row]";
+            else if (iter.kernel != BatchKernels::generic)
+                value = GetKernelCode(iter.kernel, "v" + to_string(registerValues[operand[0]]),
+                                      (iter.numberOfArguments > 1 ? "v" + to_string(registerValues[operand[1]]) : ""));
+            else {
+                // Операция без ядра вызывается через таблицу переходов
+                size_t trampoline = operations.size();
+
+                if (iter.type == CompiledExpression::unaryOperation) {
+                    auto func = expression.unaryOperations[iter.index];
+                    operations.emplace_back([func](const vector<Fraction> &args) { return func(args[0]); });
+                } else if (iter.type == CompiledExpression::binaryOperation) {
+                    auto func = expression.binaryOperations[iter.index];
+                    operations.emplace_back([func](const vector<Fraction> &args) { return func(args[0], args[1]); });
+                } else operations.push_back(expression.functions[iter.index]);
+
+                code << "        const double a" << i << "[] = {";
+                for (size_t j = 0; j < iter.numberOfArguments; j++)
+                    code << (j ? ", " : "") << "v" << registerValues[operand[j]];
+                code << "};\n";
+
+                value = "mathparser_trampolines[" + to_string(trampoline) + "].call(mathparser_trampolines[" +
+                        to_string(trampoline) + "].context, a" + to_string(i) + ", " +
+                        to_string(iter.numberOfArguments) + ")";
+            }
+
+            code << "        const double v" << i << " = " << value << ";\n";
+            registerValues[iter.result] = i;
+        }
+
+        code << "        result[row] = v" << registerValues[expression.instructions.back().result] << ";\n"
+             << "    }\n"
+             << "}\n\n";
+    }
+
+    code << "}\n";
+
+    source = code.str();
+}
+
+void NativeModule::Load() {
+    // Загружаем только обычный файл, который не может подменить другой пользователь
+    struct stat status{};
+    if (lstat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode) || !IsPrivate(status))
+        throw runtime_error("Ошибка. Модуль " + path + " не принадлежит пользователю или доступен для записи другим");
+
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) throw runtime_error("Ошибка. Не удалось загрузить модуль: " + string(dlerror()));
+
+    for (auto &iter: operations) trampolines.push_back({CallTrampoline, &iter});
+
+    for (size_t i = 0; i < expressions.size(); i++) {
+        auto code = (Code) dlsym(handle, ("mathparser_expression_" + to_string(i)).c_str());
+        if (!code) throw runtime_error("Ошибка. Модуль " + path + " поврежден");
+        codes.push_back(code);
+    }
+}
+
+double NativeModule::CallTrampoline(void *context, const double *args, size_t numberOfArguments) {
+    const auto &operation = *(const function<Fraction(const vector<Fraction> &)> *) context;
+
+    try {
+        vector<Fraction> values;
+        for (size_t i = 0; i < numberOfArguments; i++) values.emplace_back((long double) args[i]);
+
+        return (double) (long double) operation(values);
+    } catch (exception &error) {
+        return numeric_limits<double>::quiet_NaN();
+    }
+}
+
+size_t NativeModule::GetNumberOfExpressions() const { return expressions.size(); }
+
+const vector<string> &NativeModule::GetVariables(size_t expression) const {
+    return expressions.at(expression).GetVariables();
+}
+
+double NativeModule::Eval(size_t expression, span<const double> values) const {
+    const vector<string> &variables = GetVariables(expression);
+    vector<const double *> columns;
+    double result = 0;
+
+    if (values.size() < variables.size())
+        throw runtime_error("Ошибка. Не задано значение переменной " + variables[values.size()]);
+
+    for (const auto &iter: values) columns.push_back(&iter);
+    // Степень вычисляется той же функцией, что и в пакетных ядрах
+    codes[expression](columns.data(), &result, 1, trampolines.data(), BatchKernels::Power);
+
+    return result;
+}
+
+void NativeModule::EvalBatch(size_t expression, span<const double *const> columns, span<double> result) const {
+    const vector<string> &variables = GetVariables(expression);
+
+    if (columns.size() < variables.size())
+        throw runtime_error("Ошибка. Не задан столбец переменной " + variables[columns.size()]);
+
+    codes[expression](columns.data(), result.data(), result.size(), trampolines.data(), BatchKernels::Power);
+}
+
+const string &NativeModule::GetSource() const { return source; }
+
+const string &NativeModule::GetPath() const { return path; }
+
+bool NativeModule::IsLoadedFromCache() const { return isLoadedFromCache; }
@@ -1,42 +1,161 @@
 #include "../include/Operations.hpp"
 
+Operations::Operations() : snapshot(make_shared<const Snapshot>()) {}
+
+Operations::Operations(shared_ptr<const Snapshot> base) : snapshot(make_shared<const Snapshot>(std::move(base))) {}
+
 Operations &Operations::GetInstance() {
     // onlyInstance - статическая переменная для гарантии наличия только одного экземпляра класса Operations
     static Operations onlyInstance;
     return onlyInstance;
 }
 
+shared_ptr<const Operations::Snapshot> Operations::GetSnapshot() const { return snapshot.load(); }
+
+// Писатели проверяют имя и строят новый снимок под writeLock, читатели в это время работают со старым снимком
 void Operations::AddBinaryOperation(const string &name,
-                                    const function<Fraction(const Fraction &, const Fraction &)> &func, int priority) {
-    if (IsBinaryOperation(name)) throw runtime_error("Такая операция уже есть");
-    binaryOperations[name] = func;
-    priorities[name] = priority;
+                                    const function<Fraction(const Fraction &, const Fraction &)> &func, int priority,
+                                    bool isPure) {
+    lock_guard<mutex> guard(writeLock);
+    auto current = snapshot.load();
+
+    const Descriptor *descriptor = current->Find(name);
+    if (descriptor && descriptor->binary) throw runtime_error("Такая операция уже есть");
+
+    auto next = make_shared<Snapshot>(*current);
+    next->Register(name).binary = &(next->binaryOperations[name] = {func, priority, isPure});
+    snapshot.store(std::move(next));
 }
 
 
-void Operations::AddUnaryOperation(const string &name, const function<Fraction(const Fraction &)> &func, int priority) {
-    if (IsUnaryOperation(name)) throw runtime_error("Такая операция уже есть");
-    unaryOperations[name] = func;
-    priorities[name] = priority;
+void Operations::AddUnaryOperation(const string &name, const function<Fraction(const Fraction &)> &func, int priority,
+                                   bool isPure) {
+    lock_guard<mutex> guard(writeLock);
+    auto current = snapshot.load();
+
+    const Descriptor *descriptor = current->Find(name);
+    if (descriptor && descriptor->unary) throw runtime_error("Такая операция уже есть");
+
+    auto next = make_shared<Snapshot>(*current);
+    next->Register(name).unary = &(next->unaryOperations[name] = {func, priority, isPure});
+    snapshot.store(std::move(next));
 }
 
 
 void Operations::AddFunction(const string &name, const function<Fraction(const vector<Fraction> &)> &func, int priority,
-                             int numberOfArguments) {
-    if (IsFunction(name)) throw runtime_error("Такая функция уже есть");
-    if (IsUnaryOperation(name) || IsBinaryOperation(name))
+                             int numberOfArguments, bool isPure) {
+    lock_guard<mutex> guard(writeLock);
+    auto current = snapshot.load();
+
+    const Descriptor *descriptor = current->Find(name);
+    if (descriptor && descriptor->function) throw runtime_error("Такая функция уже есть");
+    if (descriptor && (descriptor->unary || descriptor->binary))
         throw runtime_error("Нельзя задавать имя функции такое же, как у операций");
     if (numberOfArguments < 0) throw runtime_error("Количество аргументов должно быть неотрицательным числом");
 
-    functions[name] = func;
-    priorities[name] = priority;
-    numberOfFunctionArguments[name] = numberOfArguments;
+    auto next = make_shared<Snapshot>(*current);
+    next->Register(name).function = &(next->functions[name] = {func, priority, numberOfArguments, isPure});
+    snapshot.store(std::move(next));
 }
 
 bool Operations::IsBinaryOperation(const string &name) {
-    return (binaryOperations.find(name) != binaryOperations.end());
+    const Descriptor *descriptor = GetSnapshot()->Find(name);
+    return (descriptor && descriptor->binary);
+}
+
+bool Operations::IsUnaryOperation(const string &name) {
+    const Descriptor *descriptor = GetSnapshot()->Find(name);
+    return (descriptor && descriptor->unary);
+}
+
+bool Operations::IsFunction(const string &name) {
+    const Descriptor *descriptor = GetSnapshot()->Find(name);
+    return (descriptor && descriptor->function);
+}
+
+size_t Operations::Hash(string_view name) {
+    size_t hash = 14695981039346656037ull;
+
+    for (char symbol: name) {
+        hash ^= (unsigned char) symbol;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+Operations::Snapshot::Snapshot() {
+    // Встроенным операциям и функциям назначаются ядра пакетного вычисления, по ним же выбираются команды байт-кода
+    for (auto &[name, operation]: binaryOperations) operation.kernel = BatchKernels::FindBinaryKernel(name);
+    for (auto &[name, operation]: unaryOperations) operation.kernel = BatchKernels::FindUnaryKernel(name);
+    for (auto &[name, operation]: functions) operation.kernel = BatchKernels::FindFunctionKernel(name);
+
+    Rebuild();
 }
 
-bool Operations::IsUnaryOperation(const string &name) { return (unaryOperations.find(name) != unaryOperations.end()); }
+// Словари слоя инициализируются явно пустыми, встроенные операции берутся из базового снимка
+Operations::Snapshot::Snapshot(shared_ptr<const Snapshot> base)
+        : binaryOperations(), unaryOperations(), functions(), base(std::move(base)) {}
 
-bool Operations::IsFunction(const string &name) { return (functions.find(name) != functions.end()); }
\ No newline at end of file
+Operations::Snapshot::Snapshot(const Snapshot &other)
+        : binaryOperations(other.binaryOperations), unaryOperations(other.unaryOperations), functions(other.functions),
+          version(other.version + 1), base(other.base) {
+    Rebuild();
+}
+
+void Operations::Snapshot::Rebuild() {
+    for (auto &[name, operation]: binaryOperations) Register(name).binary = &operation;
+    for (auto &[name, operation]: unaryOperations) Register(name).unary = &operation;
+    for (auto &[name, operation]: functions) Register(name).function = &operation;
+}
+
+size_t Operations::Snapshot::GetVersion() const { return version; }
+
+Operations::Descriptor &Operations::Snapshot::Register(const string &name) {
+    // Держим заполненность не больше половины, чтобы цепочки пробирования оставались короткими
+    if ((numberOfNames + 1) * 2 > registry.size()) {
+        vector<Descriptor> oldRegistry(max<size_t>(registry.size() * 2, 16));
+        swap(registry, oldRegistry);
+
+        for (auto &descriptor: oldRegistry) {
+            if (descriptor.name.empty()) continue;
+
+            size_t position = descriptor.hash & (registry.size() - 1);
+            while (!registry[position].name.empty()) position = (position + 1) & (registry.size() - 1);
+            registry[position] = std::move(descriptor);
+        }
+    }
+
+    size_t hash = Hash(name);
+    size_t position = hash & (registry.size() - 1);
+
+    while (!registry[position].name.empty()) {
+        if (registry[position].hash == hash && registry[position].name == name) return registry[position];
+        position = (position + 1) & (registry.size() - 1);
+    }
+
+    if (base) {
+        const Descriptor *inherited = base->Find(name);
+        if (inherited) registry[position] = *inherited;
+    }
+
+    registry[position].name = name;
+    registry[position].hash = hash;
+    numberOfNames++;
+
+    return registry[position];
+}
+
+const Operations::Descriptor *Operations::Snapshot::Find(string_view name) const {
+    if (name.empty()) return nullptr;
+
+    if (!registry.empty()) {
+        size_t hash = Hash(name);
+
+        for (size_t position = hash & (registry.size() - 1); !registry[position].name.empty();
+             position = (position + 1) & (registry.size() - 1))
+            if (registry[position].hash == hash && registry[position].name == name) return &registry[position];
+    }
+
+    return (base ? base->Find(name) : nullptr);
+}
@@ -0,0 +1,144 @@
+#include "../include/ThreadPool.hpp"
+
+#include <chrono>
+
+// Время выполнения одной порции, к которому подстраивается ее размер: порция должна быть заметно дороже
+// обращения к очереди, но достаточно мелкой, чтобы поток быстро замечал простаивающих соседей
+static const chrono::nanoseconds targetTimeOfChunk = chrono::microseconds(50);
+
+ThreadPool::ThreadPool(size_t numberOfThreads) {
+    if (numberOfThreads == 0) numberOfThreads = 1;
+
+    for (size_t i = 0; i < numberOfThreads; i++) queues.push_back(make_unique<Queue>());
+    for (size_t i = 0; i + 1 < numberOfThreads; i++) threads.emplace_back(&ThreadPool::Work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        isStopped = true;
+    }
+    wakeUp.notify_all();
+
+    for (auto &iter: threads) iter.join();
+}
+
+size_t ThreadPool::GetNumberOfThreads() const { return queues.size(); }
+
+void ThreadPool::ParallelFor(size_t size, const function<void(size_t, size_t)> &body) {
+    if (size == 0) return;
+
+    lock_guard<mutex> parallelForGuard(parallelForLock);
+    size_t index = queues.size() - 1;
+
+    this->body = &body;
+    error = nullptr;
+    isFailed = false;
+    remaining = size;
+
+    // Весь диапазон кладется в очередь вызывающего потока, остальные потоки получат работу, украв его половины
+    {
+        lock_guard<mutex> guard(queues[index]->lock);
+        queues[index]->ranges.push_back({0, size});
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        generation++;
+    }
+    wakeUp.notify_all();
+
+    Run(index);
+    this->body = nullptr;
+
+    if (error) rethrow_exception(error);
+}
+
+void ThreadPool::Work(size_t index) {
+    size_t seenGeneration = 0;
+
+    while (true) {
+        {
+            unique_lock<mutex> guard(lock);
+            wakeUp.wait(guard, [&] { return isStopped || generation != seenGeneration; });
+            if (isStopped) return;
+            seenGeneration = generation;
+        }
+
+        Run(index);
+    }
+}
+
+void ThreadPool::Run(size_t index) {
+    Range range{};
+
+    while (remaining.load(memory_order_acquire) != 0) {
+        if (Pop(index, range)) Execute(index, range);
+        else this_thread::yield();
+    }
+}
+
+bool ThreadPool::Pop(size_t index, Range &range) {
+    // Своя очередь берется с конца: там самые мелкие и самые свежие в кэше диапазоны
+    {
+        Queue &queue = *queues[index];
+        lock_guard<mutex> guard(queue.lock);
+        if (!queue.ranges.empty()) {
+            range = queue.ranges.back();
+            queue.ranges.pop_back();
+            return true;
+        }
+    }
+
+    // Чужие очереди обходятся начиная с соседней, чтобы потоки не крали у одного и того же
+    for (size_t i = 1; i < queues.size(); i++) {
+        Queue &queue = *queues[(index + i) % queues.size()];
+        lock_guard<mutex> guard(queue.lock);
+        if (!queue.ranges.empty()) {
+            range = queue.ranges.front();
+            queue.ranges.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::Execute(size_t index, Range range) {
+    Queue &queue = *queues[index];
+    size_t chunk = 1;
+
+    while (range.begin < range.end) {
+        // Половина остатка отдается в свою очередь, только когда там пусто, то есть когда прошлую половину украли
+        // или ее не было. Так деление идет по требованию, и без простаивающих потоков очередь не трогается
+        if (range.end - range.begin > 2 * chunk) {
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.ranges.empty()) {
+                size_t middle = range.begin + (range.end - range.begin) / 2;
+                queue.ranges.push_back({middle, range.end});
+                range.end = middle;
+            }
+        }
+
+        size_t size = min(chunk, range.end - range.begin);
+
+        if (!isFailed.load(memory_order_relaxed)) {
+            auto begin = chrono::steady_clock::now();
+
+            try {
+                (*body)(range.begin, range.begin + size);
+            } catch (...) {
+                lock_guard<mutex> guard(errorLock);
+                if (!error) error = current_exception();
+                isFailed = true;
+            }
+
+            // Размер порции удваивается, пока она быстрее целевого времени, и уменьшается, если она стала дороже
+            auto elapsed = chrono::steady_clock::now() - begin;
+            if (elapsed < targetTimeOfChunk / 2) chunk *= 2;
+            else if (elapsed > targetTimeOfChunk * 2 && chunk > 1) chunk /= 2;
+        }
+
+        range.begin += size;
+        remaining.fetch_sub(size, memory_order_release);
+    }
+}
@@ -0,0 +1,202 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../include/ExpressionCache.hpp"
+
+using namespace std;
+
+/**
+ * Пакетное вычисление файла выражений, по одному выражению в строке
+ * Файл из аргумента отображается в память, без аргумента выражения читаются со стандартного ввода блоками
+ * Повторяющиеся выражения компилируются один раз благодаря ExpressionCache
+ * Ответы (или сообщения об ошибках) выводятся по одному в строке через буфер, который сбрасывается только
+ * при заполнении, пустой строке соответствует пустая строка ответа, поэтому N-й ответ относится к N-й строке
+ * Статистика пропускной способности выводится в stderr
+ */
+
+// Размер блока чтения стандартного ввода и буфера вывода
+const size_t sizeOfBlock = 1 << 20;
+
+/**
+ * Класс буферизованного вывода в файловый дескриптор
+ */
+class OutputBuffer {
+private:
+    int descriptor;
+    vector<char> buffer;
+    size_t size = 0;
+
+public:
+    explicit OutputBuffer(int descriptor) : descriptor(descriptor), buffer(sizeOfBlock) {}
+
+    void Write(const char *data, size_t length) {
+        if (size + length > buffer.size()) Flush();
+
+        // Строка длиннее буфера пишется напрямую
+        if (length > buffer.size()) {
+            WriteAll(data, length);
+            return;
+        }
+
+        memcpy(buffer.data() + size, data, length);
+        size += length;
+    }
+
+    void Flush() {
+        WriteAll(buffer.data(), size);
+        size = 0;
+    }
+
+private:
+    void WriteAll(const char *data, size_t length) {
+        while (length > 0) {
+            ssize_t written = write(descriptor, data, length);
+            if (written < 0) throw runtime_error("Ошибка. Не удалось записать ответ");
+            data += written;
+            length -= (size_t) written;
+        }
+    }
+};
+
+/**
+ * Структура счетчиков обработанных данных
+ */
+struct Statistics {
+    size_t numberOfLines = 0;
+    size_t numberOfErrors = 0;
+    size_t numberOfBytes = 0;
+};
+
+// Кэш скомпилированных выражений на всю обработку, один поток - один сегмент
+static ExpressionCache cache(4096, 1);
+
+// Вычисляет одну строку и записывает ответ
+static void EvalLine(const char *begin, const char *end, string &line, OutputBuffer &output, Statistics &statistics) {
+    char answer[64];
+
+    if (end != begin && end[-1] == '\r') end--;
+
+    statistics.numberOfLines++;
+
+    // Пустая строка дает пустой ответ, чтобы номера ответов совпадали с номерами строк
+    if (end == begin) {
+        output.Write("\n", 1);
+        return;
+    }
+
+    line.assign(begin, end);
+
+    try {
+        int length = snprintf(answer, sizeof(answer), "%Lg\n", (long double) cache.Get(line)->Eval());
+        output.Write(answer, (size_t) length);
+    } catch (exception &error) {
+        statistics.numberOfErrors++;
+        output.Write(error.what(), strlen(error.what()));
+        output.Write("\n", 1);
+    }
+}
+
+// Вычисляет все строки блока, возвращает начало последней незавершенной строки
+static const char *EvalBlock(const char *begin, const char *end, string &line, OutputBuffer &output,
+                             Statistics &statistics) {
+    while (begin < end) {
+        auto *newline = (const char *) memchr(begin, '\n', (size_t) (end - begin));
+        if (!newline) break;
+
+        EvalLine(begin, newline, line, output, statistics);
+        begin = newline + 1;
+    }
+
+    return begin;
+}
+
+static void EvalFile(const char *fileName, OutputBuffer &output, Statistics &statistics) {
+    string line;
+    struct stat information{};
+
+    int descriptor = open(fileName, O_RDONLY);
+    if (descriptor < 0) throw runtime_error(string("Ошибка. Не удалось открыть файл ") + fileName);
+
+    if (fstat(descriptor, &information) != 0) {
+        close(descriptor);
+        throw runtime_error(string("Ошибка. Не удалось открыть файл ") + fileName);
+    }
+
+    size_t size = (size_t) information.st_size;
+    statistics.numberOfBytes += size;
+
+    if (size > 0) {
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            throw runtime_error(string("Ошибка. Не удалось отобразить файл ") + fileName);
+        }
+        // Файл читается один раз от начала к концу
+        madvise(data, size, MADV_SEQUENTIAL);
+
+        const char *begin = (const char *) data, *end = begin + size;
+        const char *rest = EvalBlock(begin, end, line, output, statistics);
+        if (rest != end) EvalLine(rest, end, line, output, statistics);
+
+        munmap(data, size);
+    }
+
+    close(descriptor);
+}
+
+static void EvalStream(int descriptor, OutputBuffer &output, Statistics &statistics) {
+    vector<char> buffer(sizeOfBlock);
+    size_t size = 0;
+    string line;
+
+    while (true) {
+        // Буфер растет, только если одна строка длиннее блока
+        if (size == buffer.size()) buffer.resize(buffer.size() * 2);
+
+        ssize_t count = read(descriptor, buffer.data() + size, buffer.size() - size);
+        if (count < 0) throw runtime_error("Ошибка. Не удалось прочитать стандартный ввод");
+        if (count == 0) break;
+
+        size += (size_t) count;
+        statistics.numberOfBytes += (size_t) count;
+        const char *rest = EvalBlock(buffer.data(), buffer.data() + size, line, output, statistics);
+
+        // Незавершенная строка переносится в начало буфера
+        size -= (size_t) (rest - buffer.data());
+        memmove(buffer.data(), rest, size);
+    }
+
+    if (size > 0) EvalLine(buffer.data(), buffer.data() + size, line, output, statistics);
+}
+
+int main(int argc, char **argv) {
+    Statistics statistics;
+    auto begin = chrono::steady_clock::now();
+
+    try {
+        OutputBuffer output(STDOUT_FILENO);
+
+        if (argc > 1) EvalFile(argv[1], output, statistics);
+        else EvalStream(STDIN_FILENO, output, statistics);
+
+        output.Flush();
+    } catch (exception &error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    fprintf(stderr, "Строк: %zu, ошибок: %zu, байт: %zu, время: %.3f с, %.2f МБ/с, %.0f строк/с\n",
+            statistics.numberOfLines, statistics.numberOfErrors, statistics.numberOfBytes, seconds,
+            (double) statistics.numberOfBytes / (1 << 20) / seconds, (double) statistics.numberOfLines / seconds);
+
+    return 0;
+}
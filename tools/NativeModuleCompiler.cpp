@@ -0,0 +1,41 @@
+#include <iostream>
+#include "../include/NativeModule.hpp"
+
+using namespace std;
+
+/**
+ * Заранее собирает модуль машинного кода для набора выражений и сохраняет его в кэш
+ * Выражения читаются со стандартного ввода по одному в строке, пустые строки пропускаются
+ * Аргументы: [каталог кэша] [компилятор] [флаги], с флагом --source выводится сгенерированный код
+ * Пустой каталог кэша означает каталог пользователя, как у NativeModule по умолчанию
+ * Программа, создающая NativeModule с теми же выражениями и параметрами, загрузит модуль без сборки
+ */
+int main(int argc, char **argv) {
+    vector<string> arguments, expressions;
+    bool isSourceShown = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--source") isSourceShown = true;
+        else arguments.emplace_back(argv[i]);
+    }
+
+    for (string line; getline(cin, line);)
+        if (!line.empty()) expressions.push_back(line);
+
+    try {
+        if (arguments.size() > 3) throw runtime_error("Ошибка. Лишние аргументы");
+
+        NativeModule module = (arguments.size() == 3 ? NativeModule(expressions, arguments[0], arguments[1], arguments[2]) :
+                               arguments.size() == 2 ? NativeModule(expressions, arguments[0], arguments[1]) :
+                               arguments.size() == 1 ? NativeModule(expressions, arguments[0]) :
+                               NativeModule(expressions));
+
+        if (isSourceShown) cout << module.GetSource();
+        cout << module.GetPath() << (module.IsLoadedFromCache() ? " (из кэша)" : " (собран)") << endl;
+    } catch (exception &error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}